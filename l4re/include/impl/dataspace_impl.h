@@ -17,6 +17,8 @@
 L4_RPC_DEF(L4Re::Dataspace::clear);
 L4_RPC_DEF(L4Re::Dataspace::allocate);
 L4_RPC_DEF(L4Re::Dataspace::copy_in);
+L4_RPC_DEF(L4Re::Dataspace::copy_in_many);
+L4_RPC_DEF(L4Re::Dataspace::clone);
 L4_RPC_DEF(L4Re::Dataspace::info);
 L4_RPC_DEF(L4Re::Dataspace::map_info);
 
@@ -10,16 +10,22 @@
  * License: see LICENSE.spdx (in this directory or the directories above)
  */
 #include <l4/re/namespace>
+#include <l4/re/env>
 
 #include <l4/util/util.h>
 #include <l4/sys/cxx/ipc_client>
 #include <l4/sys/assert.h>
+#include <l4/sys/factory>
+#include <l4/sys/kip.h>
+#include <l4/sys/semaphore>
+#include <l4/sys/task>
 
 #include <string.h>
 
 L4_RPC_DEF(L4Re::Namespace::query);
 L4_RPC_DEF(L4Re::Namespace::register_obj);
 L4_RPC_DEF(L4Re::Namespace::unlink);
+L4_RPC_DEF(L4Re::Namespace::notify);
 
 namespace L4Re {
 
@@ -62,6 +68,36 @@ Namespace::_query(char const *name, unsigned len,
   return _name.length;
 }
 
+l4_ret_t
+Namespace::_wait(char const *name, unsigned len, L4::Cap<void> const &slot,
+                 long timeout) const noexcept
+{
+  // Only entries of this name space can be waited for, the name space
+  // responsible for a nested name is not at hand here.
+  if (memchr(name, '/', len))
+    return -L4_ENOSYS;
+
+  // The target slot is unused until the name resolves, borrow it for the
+  // semaphore the server triggers. Never replace what the caller keeps
+  // there, poll instead.
+  L4Re::Env const *e = L4Re::Env::env();
+  if (e->task()->cap_valid(slot).label() > 0)
+    return -L4_EEXIST;
+
+  L4::Cap<L4::Semaphore> sem = L4::cap_reinterpret_cast<L4::Semaphore>(slot);
+  l4_ret_t ret = l4_error(e->factory()->create(sem));
+  if (ret < 0)
+    return ret;
+
+  ret = notify(name, len, sem);
+  if (ret >= 0)
+    sem->down(l4_timeout(L4_IPC_TIMEOUT_NEVER,
+                         l4_timeout_from_us(timeout * 1000ULL)));
+
+  e->task()->unmap(sem.fpage(), L4_FP_ALL_SPACES | L4_FP_DELETE_OBJ);
+  return ret;
+}
+
 l4_ret_t
 Namespace::query(char const *name, unsigned len, L4::Cap<void> const &target,
                  int timeout, l4_umword_t *local_id, bool iterate) const noexcept
@@ -75,6 +111,7 @@ Namespace::query(char const *name, unsigned len, L4::Cap<void> const &target,
   l4_ret_t ret;
   long rem = timeout;
   long to = 0;
+  bool use_notify = true;
 
   if (rem)
     to = 10;
@@ -89,6 +126,22 @@ Namespace::query(char const *name, unsigned len, L4::Cap<void> const &target,
       if (L4_UNLIKELY(ret != -L4_EAGAIN))
         return ret;
 
+      if (use_notify && rem > 0)
+        {
+          // Block until the entry changes instead of polling for it.
+          l4_cpu_time_t start = l4_kip_clock(l4re_kip());
+          if (_wait(name, len, target, rem) >= 0)
+            {
+              rem -= (l4_kip_clock(l4re_kip()) - start) / 1000;
+              if (rem <= 0)
+                to = rem = 0; // one final try
+              continue;
+            }
+
+          // Server does not support notifications, fall back to polling.
+          use_notify = false;
+        }
+
       if (rem == to)
         return ret;
 
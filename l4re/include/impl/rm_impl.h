@@ -30,6 +30,8 @@ L4_RPC_DEF(L4Re::Rm::find);
 L4_RPC_DEF(L4Re::Rm::get_info);
 L4_RPC_DEF(L4Re::Rm::add_rescue_jump);
 L4_RPC_DEF(L4Re::Rm::remove_rescue_jump);
+L4_RPC_DEF(L4Re::Rm::attach_many);
+L4_RPC_DEF(L4Re::Rm::detach_many);
 
 namespace L4Re
 {
@@ -60,27 +62,10 @@ Rm::attach(l4_addr_t *start, unsigned long size, Rm::Flags flags,
   return 0;
 }
 
-l4_ret_t
-Rm::detach(l4_addr_t start, unsigned long size, L4::Cap<Dataspace> *mem,
-           L4::Cap<L4::Task> task, unsigned flags) const noexcept
+static void
+unmap_range(L4::Cap<L4::Task> task, l4_addr_t rstart,
+            unsigned long rsize) noexcept
 {
-  l4_addr_t rstart = 0, rsize = 0;
-  l4_cap_idx_t mem_cap = L4_INVALID_CAP;
-  l4_ret_t e = detach_t::call(c(), start, size, flags, rstart, rsize, mem_cap);
-  if (L4_UNLIKELY(e < 0))
-    return e;
-
-  if (mem)
-    *mem = L4::Cap<L4Re::Dataspace>(mem_cap);
-
-  if (e & Unmapped_range)
-    // Hide Unmapped_range bit. Some callers incorrectly treat anything except
-    // zero as failure.
-    return e & ~Unmapped_range;
-
-  if (!task.is_valid())
-    return e;
-
   rsize = l4_round_page(rsize);
   unsigned order = L4_LOG2_PAGESIZE;
   unsigned long sz = (1UL << order);
@@ -108,7 +93,126 @@ Rm::detach(l4_addr_t start, unsigned long size, L4::Cap<Dataspace> *mem,
       task->unmap(l4_fpage(p, order, L4_FPAGE_RWX),
                   L4_FP_ALL_SPACES);
     }
+}
+
+l4_ret_t
+Rm::attach_many(Attach_region *regions, unsigned num,
+                L4::Ipc::Cap<Dataspace> mem0, L4::Ipc::Cap<Dataspace> mem1,
+                char const *name, unsigned *failed,
+                L4::Cap<L4::Task> const task) const noexcept
+{
+  if (num == 0 || num > Max_batch_regions)
+    return -L4_EINVAL;
+
+  // An invalid optional capability is not transferred at all.
+  if (mem1.is_valid() && !mem0.is_valid())
+    return -L4_EINVAL;
+
+  for (unsigned i = 0; i < num; ++i)
+    if (regions[i].mem >= Max_batch_ds)
+      return -L4_EINVAL;
+
+  char const n = '\0';
+  l4_addr_t starts[Max_batch_regions];
+  L4::Ipc::Array<l4_addr_t, unsigned char> s(Max_batch_regions, starts);
+  l4_ret_t error = 0;
+  l4_ret_t e = attach_many_t::call(c(),
+                                   L4::Ipc::Array<Attach_region const,
+                                                  unsigned char>(num, regions),
+                                   mem0, mem1, mem0.cap().cap(),
+                                   mem1.cap().cap(), name ? name : &n,
+                                   s, error);
+  if (e < 0)
+    return e;
+
+  if (static_cast<unsigned>(e) < num)
+    {
+      if (failed)
+        *failed = e;
+      return error < 0 ? error : -L4_EINVAL;
+    }
+
+  if (s.length < num)
+    return -L4_EMSGTOOSHORT;
+
+  for (unsigned i = 0; i < num; ++i)
+    {
+      Attach_region &r = regions[i];
+      r.start = starts[i];
+
+#ifdef CONFIG_MMU
+      bool eager = (r.flags & (F::Eager_map | F::No_eager_map)) == F::Eager_map;
+#else
+      bool eager = !(r.flags & F::No_eager_map)
+                   && (r.mem ? mem1 : mem0).is_valid();
+#endif
+      if (eager)
+        page_in(r.start, r.size, r.flags.region_flags() & F::RWX, task);
+    }
+
+  return 0;
+}
+
+l4_ret_t
+Rm::detach_many(Detach_region const *regions, unsigned num, unsigned *failed,
+                L4::Cap<L4::Task> const &task) const noexcept
+{
+  if (num == 0 || num > Max_batch_regions)
+    return -L4_EINVAL;
+
+  l4_ret_t error = 0;
+  l4_umword_t unmapped = 0;
+  l4_ret_t e = detach_many_t::call(c(),
+                                   L4::Ipc::Array<Detach_region const,
+                                                  unsigned char>(num, regions),
+                                   error, unmapped);
+  if (e < 0)
+    return e;
+
+  unsigned done = static_cast<unsigned>(e) < num ? e : num;
+  // The failing interval might be detached partly, unmap it as well.
+  unsigned touched = done < num ? done + 1 : num;
+  if (task.is_valid())
+    for (unsigned i = 0; i < touched; ++i)
+      if (!(unmapped & (1UL << i)))
+        {
+          l4_addr_t start = l4_trunc_page(regions[i].start);
+          unmap_range(task, start,
+                      regions[i].start - start + regions[i].size);
+        }
+
+  if (done < num)
+    {
+      if (failed)
+        *failed = done;
+      return error < 0 ? error : -L4_EINVAL;
+    }
+
+  return 0;
+}
+
+l4_ret_t
+Rm::detach(l4_addr_t start, unsigned long size, L4::Cap<Dataspace> *mem,
+           L4::Cap<L4::Task> task, unsigned flags) const noexcept
+{
+  l4_addr_t rstart = 0, rsize = 0;
+  l4_cap_idx_t mem_cap = L4_INVALID_CAP;
+  l4_ret_t e = detach_t::call(c(), start, size, flags, rstart, rsize, mem_cap);
+  if (L4_UNLIKELY(e < 0))
+    return e;
+
+  if (mem)
+    *mem = L4::Cap<L4Re::Dataspace>(mem_cap);
+
+  if (e & Unmapped_range)
+    // Hide Unmapped_range bit. Some callers incorrectly treat anything except
+    // zero as failure.
+    return e & ~Unmapped_range;
+
+  if (!task.is_valid())
+    return e;
 
+  unmap_range(task, rstart, rsize);
   return e;
 }
 
@@ -19,6 +19,6 @@ namespace L4Re {
      * \ingroup api_l4re_protocols
      * \internal
      */
-    enum Opcodes { Query, Register, Link, Unlink };
+    enum Opcodes { Query, Register, Link, Unlink, Notify };
   };
 };
@@ -14,6 +14,7 @@ L4_RPC_DEF(L4Re::Event::get_stream_info);
 L4_RPC_DEF(L4Re::Event::get_stream_info_for_id);
 L4_RPC_DEF(L4Re::Event::get_axis_info);
 L4_RPC_DEF(L4Re::Event::get_stream_state_for_id);
+L4_RPC_DEF(L4Re::Event::get_num_dropped);
 
 
 
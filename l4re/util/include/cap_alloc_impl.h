@@ -38,7 +38,7 @@ namespace L4Re { namespace Util {
 // is automatically linked against.
 #if defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_1) || defined(ARCH_arm) || defined(ARCH_riscv)
 using _Cap_alloc_impl
-  = Counting_cap_alloc<L4Re::Util::Counter_atomic<unsigned char>,
+  = Magazine_cap_alloc<L4Re::Util::Counter_atomic<unsigned char>,
                        L4Re::Util::Dbg>;
 #elif defined(ARCH_sparc)
 using _Cap_alloc_impl
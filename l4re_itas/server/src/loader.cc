@@ -133,6 +133,26 @@ L4Re_app_model::prog_attach_ds(l4_addr_t addr, unsigned long size,
                            name, file_offset), what);
 }
 
+void
+L4Re_app_model::prog_attach_segments(Prog_segment const *segs, unsigned num,
+                                     char const *name, char const *what)
+{
+  L4Re::Rm::Flags flags(0);
+  if (Global::l4re_aux->ldr_flags & L4RE_AUX_LDR_FLAG_EAGER_MAP)
+    flags |= L4Re::Rm::F::Eager_map;
+
+  Ldr::attach_prog_segments(_rm, segs, num, name, flags,
+                            L4::Cap<L4::Task>::Invalid,
+                            [](Const_dataspace ds) { return ds; },
+                            [&](Prog_segment const &s)
+                            {
+                              prog_attach_ds(s.addr, s.size, s.ds, s.offset,
+                                             s.flags, name, s.file_offset,
+                                             what);
+                            },
+                            what);
+}
+
 void
 L4Re_app_model::copy_ds(Dataspace dst, unsigned long dst_offs,
                         Const_dataspace src, unsigned long src_offs,
@@ -142,6 +162,15 @@ L4Re_app_model::copy_ds(Dataspace dst, unsigned long dst_offs,
                "l4re_itas: Copy-in failed.");
 }
 
+void
+L4Re_app_model::copy_ds_many(Dataspace dst, Const_dataspace src,
+                             L4Re::Dataspace::Copy_range const *ranges,
+                             unsigned num)
+{
+  Ldr::copy_ds_ranges(dst, src, ranges, num,
+                      "l4re_itas: Copy-in failed.");
+}
+
 void
 L4Re_app_model::ds_map_info(Const_dataspace ds, l4_addr_t *start)
 {
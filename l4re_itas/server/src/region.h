@@ -131,11 +131,13 @@ using Region_map_interface =
 
 
 class Region_map
-: public L4Re::Util::Region_map<Region_handler, cxx::New_allocator>,
+: public L4Re::Util::Region_map<Region_handler, cxx::New_allocator,
+                                L4Re::Util::Btree_region_tree<>>,
   public L4Re::Util::Rm_server<Region_map, Dbg>
 {
 private:
-  typedef L4Re::Util::Region_map<Region_handler, cxx::New_allocator> Base;
+  typedef L4Re::Util::Region_map<Region_handler, cxx::New_allocator,
+                                 L4Re::Util::Btree_region_tree<>> Base;
 
 #ifdef CONFIG_MMU
   /// Size of pool for anonymous memory allocations
@@ -301,6 +303,24 @@ public:
                                  align, client_cap_idx, name, backing_offset);
   }
 
+  long op_attach_many(L4Re::Rm::Rights rights,
+                      L4::Ipc::Array_in_buf<L4Re::Rm::Attach_region,
+                                            unsigned char,
+                                            L4Re::Rm::Max_batch_regions>
+                        const &regions,
+                      L4::Ipc::Snd_fpage ds_cap0, L4::Ipc::Snd_fpage ds_cap1,
+                      l4_cap_idx_t client_cap_idx0,
+                      l4_cap_idx_t client_cap_idx1,
+                      L4::Ipc::String<> name,
+                      L4::Ipc::Array_ref<l4_addr_t, unsigned char> &starts,
+                      l4_ret_t &error)
+  {
+    Rw_lock_write_scope scope(_lock);
+    return _region_map.op_attach_many(rights, regions, ds_cap0, ds_cap1,
+                                      client_cap_idx0, client_cap_idx1, name,
+                                      starts, error);
+  }
+
   long op_free_area(L4Re::Rm::Rights rights, l4_addr_t start)
   {
     Rw_lock_write_scope scope(_lock);
@@ -325,6 +345,17 @@ public:
                                  mem_cap);
   }
 
+  long op_detach_many(L4Re::Rm::Rights rights,
+                      L4::Ipc::Array_in_buf<L4Re::Rm::Detach_region,
+                                            unsigned char,
+                                            L4Re::Rm::Max_batch_regions>
+                        const &regions,
+                      l4_ret_t &error, l4_umword_t &unmapped)
+  {
+    Rw_lock_write_scope scope(_lock);
+    return _region_map.op_detach_many(rights, regions, error, unmapped);
+  }
+
   long op_reserve_area(L4Re::Rm::Rights rights, l4_addr_t &start,
                        unsigned long size, L4Re::Rm::Flags flags,
                        unsigned char align)
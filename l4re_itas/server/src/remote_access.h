@@ -54,6 +54,15 @@ public:
                       L4Re::Dataspace::Size)
   { return -L4_ENOSYS; }
 
+  l4_ret_t op_copy_in_many(L4Re::Dataspace::Rights,
+                           L4::Ipc::Snd_fpage,
+                           L4::Ipc::Array_ref<L4Re::Dataspace::Copy_range const,
+                                              unsigned char>)
+  { return -L4_ENOSYS; }
+
+  l4_ret_t op_clone(L4Re::Dataspace::Rights, L4::Ipc::Cap<L4Re::Dataspace> &)
+  { return -L4_ENOSYS; }
+
   l4_ret_t op_allocate(L4Re::Dataspace::Rights,
                        L4Re::Dataspace::Offset,
                        L4Re::Dataspace::Size)
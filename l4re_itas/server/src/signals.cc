@@ -1108,6 +1108,15 @@ Signal_manager::op_raise(L4Re::Itas::Rights, L4::Ipc::Snd_fpage thread, int sig)
   return handler(thread)->raise(sig);
 }
 
+l4_ret_t
+Signal_manager::op_kill(L4Re::Itas::Rights, int sig)
+{
+  if (sig <= 0 || sig >= _NSIG)
+    return -EINVAL;
+
+  return send_process_signal(sig) ? 0 : -ENOMEM;
+}
+
 Thread_signal_handler *
 Signal_manager::handler(L4::Ipc::Snd_fpage thread)
 {
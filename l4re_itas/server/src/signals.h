@@ -361,6 +361,8 @@ public:
                     L4::Ipc::Snd_fpage thread,
                     int sig);
 
+  l4_ret_t op_kill(L4Re::Itas::Rights, int sig);
+
   void stop_all_threads();
 
 private:
@@ -9,13 +9,116 @@
 
 #include <l4/l4re_vfs/backend>
 #include <l4/sys/capability>
+#include <l4/re/env>
 #include <l4/re/namespace>
 #include <l4/re/unique_cap>
+#include <l4/sys/semaphore>
+
+#include "vfs_lock.h"
 
 namespace L4Re { namespace Core {
 
 using cxx::Ref_ptr;
 
+/**
+ * Small LRU cache for path lookups in namespace-backed directories.
+ *
+ * Each entry remembers the File_factory resolved for a path, so that opening
+ * the path again skips the L4::Meta::interface() round trip, and optionally
+ * a capability obtained by faccessat(), which the next get_entry() consumes
+ * instead of querying the name space again. Failed lookups are cached as
+ * negative entries.
+ *
+ * Cached capabilities are never handed out as copies: a copy mapped from a
+ * cache slot would be revoked together with the slot on eviction.
+ *
+ * Only names consisting of a single path component are cached, together with
+ * the name space that resolves them. The cache watches these name spaces with
+ * L4Re::Namespace::notify() and drops all entries of a name space once it
+ * reports a change. Name spaces that do not support notifications are not
+ * cached at all. Cached capabilities are validated on every hit and the entry
+ * is dropped if the object is gone.
+ *
+ * The cache is shared by all threads and protected by `lock`, which is not
+ * held while querying a name space. A lookup takes a Ticket before the query
+ * and its result is only inserted if the name space did not change since.
+ */
+class Ns_path_cache
+{
+public:
+  enum
+  {
+    Num_entries = 8,
+    Num_watches = 4,
+    Max_path    = 48,
+    // Lookups without caching after a name space refused a watch for lack
+    // of resources, doubled on every refusal.
+    Min_backoff = 16,
+    Max_backoff = 1024,
+  };
+
+  struct Watch
+  {
+    L4::Cap<L4Re::Namespace> ns;
+    L4Re::Unique_cap<L4::Semaphore> sem;
+    unsigned long gen = 0;
+    unsigned long stamp = 0;
+    unsigned backoff = 0;   ///< Lookups left until the next arm() attempt.
+    unsigned delay = 0;     ///< Backoff after the next refusal.
+    bool armed = false;
+    bool unsupported = false;
+  };
+
+  struct Entry
+  {
+    L4Re::Unique_cap<void> cap;
+    Ref_ptr<L4Re::Vfs::File_factory> factory;
+    Watch *watch = nullptr;
+    unsigned long stamp = 0;
+    unsigned char len = 0;
+    bool negative = false;
+    char path[Max_path];
+  };
+
+  /// State of the name space a lookup result belongs to.
+  struct Ticket
+  {
+    Watch *watch = nullptr;
+    unsigned long gen = 0;
+  };
+
+  /**
+   * Get a ticket for looking up a name in `ns`.
+   *
+   * Drops the entries of `ns` if it changed. The ticket is empty, and nothing
+   * gets cached, if `ns` is invalid or cannot be watched.
+   */
+  Ticket ticket(L4::Cap<L4Re::Namespace> ns) noexcept;
+
+  Entry *find(Ticket const &t, char const *path, unsigned len) noexcept;
+
+  /**
+   * Get the entry for `path`, creating it if needed.
+   *
+   * \return The entry, or nullptr if the name space changed since `t` was
+   *         taken or the path is too long.
+   */
+  Entry *insert(Ticket const &t, char const *path, unsigned len,
+                bool negative) noexcept;
+
+  void drop(Entry *e) noexcept;
+
+  Vfs_lock lock;
+
+private:
+  bool arm(Watch *w) noexcept;
+  void flush(Watch *w) noexcept;
+
+  Entry _e[Num_entries];
+  Watch _w[Num_watches];
+  unsigned long _stamp = 0;
+};
+
 class Env_dir : public L4Re::Vfs::Be_file
 {
 public:
@@ -37,10 +140,12 @@ public:
 
 private:
   int get_ds(const char *path, L4Re::Unique_cap<L4Re::Dataspace> *ds) noexcept;
+  L4::Cap<L4Re::Namespace> cache_ns(const char *path) const noexcept;
   bool check_type(Env::Cap_entry const *e, long protocol) noexcept;
 
   L4Re::Env const *_env;
   Env::Cap_entry const *_current_cap_entry;
+  Ns_path_cache _cache;
 };
 
 class Ns_dir : public L4Re::Vfs::Be_file
@@ -67,6 +172,7 @@ private:
 
   L4::Cap<L4Re::Namespace> _ns;
   size_t _current_dir_pos;
+  Ns_path_cache _cache;
 };
 
 }}
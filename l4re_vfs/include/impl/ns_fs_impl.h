@@ -7,6 +7,7 @@
  */
 #include "ns_fs.h"
 
+#include <l4/cxx/minmax>
 #include <l4/re/dataspace>
 #include <l4/re/util/env_ns>
 #include <l4/re/unique_cap>
@@ -15,8 +16,8 @@
 namespace L4Re { namespace Core {
 
 static
-Ref_ptr<L4Re::Vfs::File>
-cap_to_vfs_object(L4::Cap<void> o, int *err)
+Ref_ptr<L4Re::Vfs::File_factory>
+cap_to_file_factory(L4::Cap<void> o, int *err)
 {
   L4::Cap<L4::Meta> m = L4::cap_reinterpret_cast<L4::Meta>(o);
   long proto = 0;
@@ -26,7 +27,7 @@ cap_to_vfs_object(L4::Cap<void> o, int *err)
   *err = -ENOPROTOOPT;
   if (r < 0)
     // could not get type of object so bail out
-    return Ref_ptr<L4Re::Vfs::File>();
+    return Ref_ptr<L4Re::Vfs::File_factory>();
 
   *err = -EPROTO;
   Ref_ptr<L4Re::Vfs::File_factory> factory;
@@ -37,13 +38,334 @@ cap_to_vfs_object(L4::Cap<void> o, int *err)
   if (!factory)
     factory = L4Re::Vfs::vfs_ops->get_file_factory(name.data);
 
+  return factory;
+}
+
+bool
+Ns_path_cache::arm(Watch *w) noexcept
+{
+  if (!w->sem.is_valid())
+    {
+      auto sem = L4Re::make_unique_cap<L4::Semaphore>(L4Re::virt_cap_alloc);
+      if (!sem.is_valid()
+          || l4_error(L4Re::Env::env()->factory()->create(sem.get())) < 0)
+        return false;
+
+      w->sem = cxx::move(sem);
+    }
+
+  long r = w->ns->notify("", 0, w->sem.get());
+  w->armed = r >= 0;
+  if (w->armed)
+    w->delay = Min_backoff;
+  else if (r == -L4_EBUSY || r == -L4_ENOMEM)
+    {
+      // The name space is just short of resources. Try again later, but not
+      // on every lookup, each attempt costs an IPC and work in the server.
+      w->backoff = w->delay;
+      w->delay = cxx::min<unsigned>(w->delay * 2, Max_backoff);
+    }
+  else
+    w->unsupported = true;
+
+  return w->armed;
+}
+
+void
+Ns_path_cache::flush(Watch *w) noexcept
+{
+  for (Entry &e: _e)
+    if (e.stamp && e.watch == w)
+      drop(&e);
+
+  ++w->gen;
+}
+
+Ns_path_cache::Ticket
+Ns_path_cache::ticket(L4::Cap<L4Re::Namespace> ns) noexcept
+{
+  Ticket t;
+  if (!ns.is_valid())
+    return t;
+
+  // find the watch of the name space, otherwise reuse a free or the LRU one
+  Watch *w = &_w[0];
+  for (Watch &x: _w)
+    {
+      if (x.stamp && x.ns == ns)
+        {
+          w = &x;
+          break;
+        }
+
+      if (w->stamp && (!x.stamp || x.stamp < w->stamp))
+        w = &x;
+    }
+
+  if (!w->stamp || w->ns != ns)
+    {
+      // The semaphore may still be registered with the old name space.
+      flush(w);
+      w->sem.reset();
+      w->ns = ns;
+      w->armed = false;
+      w->unsupported = false;
+      w->backoff = 0;
+      w->delay = Min_backoff;
+    }
+
+  w->stamp = ++_stamp;
+
+  if (w->unsupported)
+    return t;
+
+  // The name space triggers the semaphore once and forgets it, so it has to
+  // be registered again after each change.
+  if (w->armed && l4_error(w->sem->down(L4_IPC_BOTH_TIMEOUT_0)) >= 0)
+    {
+      flush(w);
+      w->armed = false;
+    }
+
+  if (!w->armed)
+    {
+      if (w->backoff)
+        {
+          --w->backoff;
+          return t;
+        }
+
+      if (!arm(w))
+        return t;
+    }
+
+  t.watch = w;
+  t.gen = w->gen;
+  return t;
+}
+
+Ns_path_cache::Entry *
+Ns_path_cache::find(Ticket const &t, char const *path, unsigned len) noexcept
+{
+  if (!t.watch || len >= Max_path)
+    return nullptr;
+
+  for (Entry &e: _e)
+    {
+      if (!e.stamp || e.watch != t.watch || e.len != len
+          || memcmp(e.path, path, len))
+        continue;
+
+      if (e.cap.is_valid() && !e.cap.validate().label())
+        {
+          drop(&e);
+          return nullptr;
+        }
+
+      e.stamp = ++_stamp;
+      return &e;
+    }
+
+  return nullptr;
+}
+
+Ns_path_cache::Entry *
+Ns_path_cache::insert(Ticket const &t, char const *path, unsigned len,
+                      bool negative) noexcept
+{
+  if (!t.watch || t.watch->gen != t.gen || len >= Max_path)
+    return nullptr;
+
+  // reuse an entry for the same path, otherwise a free or the LRU one
+  Entry *v = &_e[0];
+  for (Entry &e: _e)
+    {
+      if (e.stamp && e.watch == t.watch && e.len == len
+          && !memcmp(e.path, path, len))
+        {
+          if (negative)
+            drop(&e);
+          else
+            e.negative = false;
+
+          v = &e;
+          break;
+        }
+
+      if (v->stamp && (!e.stamp || e.stamp < v->stamp))
+        v = &e;
+    }
+
+  if (!v->stamp || v->watch != t.watch || v->len != len
+      || memcmp(v->path, path, len))
+    {
+      drop(v);
+      memcpy(v->path, path, len);
+      v->len = len;
+      v->watch = t.watch;
+      v->negative = negative;
+    }
+
+  v->stamp = ++_stamp;
+  return v;
+}
+
+void
+Ns_path_cache::drop(Entry *e) noexcept
+{
+  e->cap.reset();
+  e->factory = Ref_ptr<L4Re::Vfs::File_factory>();
+  e->watch = nullptr;
+  e->stamp = 0;
+}
+
+/**
+ * Common get_entry() implementation for namespace-backed directories.
+ *
+ * \param cache   Path cache of the directory.
+ * \param ns      Name space resolving `path`, invalid if `path` must not be
+ *                cached.
+ * \param path    Path relative to the directory.
+ * \param get_ds  Callable doing the actual name space lookup for `path`.
+ * \param f       Receives the file object.
+ */
+template<typename GET_DS>
+static int
+ns_cached_get_entry(Ns_path_cache *cache, L4::Cap<L4Re::Namespace> ns,
+                    char const *path, GET_DS &&get_ds,
+                    Ref_ptr<L4Re::Vfs::File> *f) noexcept
+{
+  unsigned len = strlen(path);
+  Ns_path_cache::Ticket t;
+  L4Re::Unique_cap<Dataspace> file;
+  Ref_ptr<L4Re::Vfs::File_factory> factory;
+  int err;
+
+  {
+    Vfs_lock::Guard g(cache->lock);
+    if (!g.error())
+      {
+        t = cache->ticket(ns);
+        if (Ns_path_cache::Entry *e = cache->find(t, path, len))
+          {
+            if (e->negative)
+              return -ENOENT;
+
+            factory = e->factory;
+            if (e->cap.is_valid())
+              file = L4Re::Unique_cap<Dataspace>(
+                       L4::cap_reinterpret_cast<Dataspace>(e->cap.release()),
+                       L4Re::virt_cap_alloc);
+          }
+      }
+  }
+
+  if (!file.is_valid())
+    {
+      err = get_ds(path, &file);
+      if (err < 0)
+        {
+          if (err == -ENOENT && t.watch)
+            {
+              Vfs_lock::Guard g(cache->lock);
+              if (!g.error())
+                cache->insert(t, path, len, true);
+            }
+          return -ENOENT;
+        }
+    }
+
   if (!factory)
-    return Ref_ptr<L4Re::Vfs::File>();
+    {
+      factory = cap_to_file_factory(file.get(), &err);
+      if (!factory)
+        return err;
+
+      if (t.watch)
+        {
+          Vfs_lock::Guard g(cache->lock);
+          if (!g.error())
+            if (Ns_path_cache::Entry *e = cache->insert(t, path, len, false))
+              e->factory = factory;
+        }
+    }
 
-  *err = -ENOMEM;
-  return factory->create(o);
+  Ref_ptr<L4Re::Vfs::File> fi = factory->create(file.get());
+  if (!fi)
+    return -ENOMEM;
+
+  file.release();
+  *f = cxx::move(fi);
+  return 0;
 }
 
+/**
+ * Common faccessat() implementation for namespace-backed directories.
+ *
+ * \param cache  Path cache of the directory.
+ * \param ns     Name space resolving `path`, invalid if `path` must not be
+ *               cached.
+ * \param path   Path relative to the directory.
+ * \param mode   Access mode to check.
+ * \param query  Callable doing the name space query for `path` into the
+ *               given capability slot.
+ */
+template<typename QUERY>
+static int
+ns_cached_access(Ns_path_cache *cache, L4::Cap<L4Re::Namespace> ns,
+                 char const *path, int mode, QUERY &&query) noexcept
+{
+  unsigned len = strlen(path);
+  Ns_path_cache::Ticket t;
+  bool cached = false;
+
+  {
+    Vfs_lock::Guard g(cache->lock);
+    if (!g.error())
+      {
+        t = cache->ticket(ns);
+        if (Ns_path_cache::Entry *e = cache->find(t, path, len))
+          {
+            if (e->negative)
+              return -ENOENT;
+
+            cached = e->cap.is_valid();
+          }
+      }
+  }
+
+  if (!cached)
+    {
+      auto tmpcap = L4Re::make_unique_cap<void>(L4Re::virt_cap_alloc);
+
+      if (!tmpcap.is_valid())
+        return -ENOMEM;
+
+      long r = query(tmpcap.get());
+      if (r && r != -L4_ENOENT)
+        return -ENOENT;
+
+      if (t.watch)
+        {
+          Vfs_lock::Guard g(cache->lock);
+          if (!g.error())
+            {
+              Ns_path_cache::Entry *e = cache->insert(t, path, len, r != 0);
+              // keep the capability for a subsequent get_entry() on the path
+              if (e && !r && !e->cap.is_valid())
+                e->cap = cxx::move(tmpcap);
+            }
+        }
+
+      if (r)
+        return -ENOENT;
+    }
+
+  if (mode & W_OK)
+    return -EACCES;
+
+  return 0;
+}
 
 int
 Ns_dir::get_ds(const char *path, L4Re::Unique_cap<L4Re::Dataspace> *ds) noexcept
@@ -56,7 +378,7 @@ Ns_dir::get_ds(const char *path, L4Re::Unique_cap<L4Re::Dataspace> *ds) noexcept
   int err = _ns->query(path, file.get());
 
   if (err < 0)
-    return -ENOENT;
+    return err == -L4_ENOENT ? -ENOENT : -EIO;
 
   *ds = cxx::move(file);
   return err;
@@ -72,36 +394,19 @@ Ns_dir::get_entry(const char *path, int /*flags*/, mode_t /*mode*/,
       return 0;
     }
 
-  L4Re::Unique_cap<Dataspace> file;
-  int err = get_ds(path, &file);
-
-  if (err < 0)
-    return -ENOENT;
-
-  cxx::Ref_ptr<L4Re::Vfs::File> fi = cap_to_vfs_object(file.get(), &err);
-  if (!fi)
-    return err;
-
-  file.release();
-  *f = cxx::move(fi);
-  return 0;
+  L4::Cap<L4Re::Namespace> ns = strchr(path, '/') ? L4::Cap<L4Re::Namespace>() : _ns;
+  return ns_cached_get_entry(&_cache, ns, path,
+                             [this](char const *p, L4Re::Unique_cap<Dataspace> *ds)
+                             { return get_ds(p, ds); }, f);
 }
 
 int
 Ns_dir::faccessat(const char *path, int mode, int /*flags*/) noexcept
 {
-  auto tmpcap = L4Re::make_unique_cap<void>(L4Re::virt_cap_alloc);
-
-  if (!tmpcap.is_valid())
-    return -ENOMEM;
-
-  if (_ns->query(path, tmpcap.get()))
-    return -ENOENT;
-
-  if (mode & W_OK)
-    return -EACCES;
-
-  return 0;
+  L4::Cap<L4Re::Namespace> ns = strchr(path, '/') ? L4::Cap<L4Re::Namespace>() : _ns;
+  return ns_cached_access(&_cache, ns, path, mode,
+                          [this, path](L4::Cap<void> c)
+                          { return _ns->query(path, c); });
 }
 
 int
@@ -246,7 +551,7 @@ Env_dir::get_ds(const char *path, L4Re::Unique_cap<L4Re::Dataspace> *ds) noexcep
   int err = c->query(p.path(), p.length(), file.get());
 
   if (err < 0)
-    return -ENOENT;
+    return err == -L4_ENOENT ? -ENOENT : -EIO;
 
   *ds = cxx::move(file);
   return err;
@@ -262,19 +567,9 @@ Env_dir::get_entry(const char *path, int /*flags*/, mode_t /*mode*/,
       return 0;
     }
 
-  L4Re::Unique_cap<Dataspace> file;
-  int err = get_ds(path, &file);
-
-  if (err < 0)
-    return -ENOENT;
-
-  cxx::Ref_ptr<L4Re::Vfs::File> fi = cap_to_vfs_object(file.get(), &err);
-  if (!fi)
-    return err;
-
-  file.release();
-  *f = cxx::move(fi);
-  return 0;
+  return ns_cached_get_entry(&_cache, cache_ns(path), path,
+                             [this](char const *p, L4Re::Unique_cap<Dataspace> *ds)
+                             { return get_ds(p, ds); }, f);
 }
 
 int
@@ -302,18 +597,28 @@ Env_dir::faccessat(const char *path, int mode, int /*flags*/) noexcept
       return 0;
     }
 
-  auto tmpcap = L4Re::make_unique_cap<void>(L4Re::virt_cap_alloc);
-
-  if (!tmpcap.is_valid())
-    return -ENOMEM;
+  return ns_cached_access(&_cache, cache_ns(path), path, mode,
+                          [c, &p](L4::Cap<void> t)
+                          { return c->query(p.path(), p.length(), t); });
+}
 
-  if (c->query(p.path(), p.length(), tmpcap.get()))
-    return -ENOENT;
+/**
+ * Get the name space resolving `path` if `path` names an entry directly in
+ * one of the name spaces of the environment, which is the case that can be
+ * cached.
+ */
+L4::Cap<L4Re::Namespace>
+Env_dir::cache_ns(const char *path) const noexcept
+{
+  while (*path == '/')
+    ++path;
+  Vfs::Path p(path);
+  Vfs::Path first = p.strip_first();
 
-  if (mode & W_OK)
-    return -EACCES;
+  if (first.empty() || p.empty() || memchr(p.path(), '/', p.length()))
+    return L4::Cap<L4Re::Namespace>();
 
-  return 0;
+  return _env->get_cap<L4Re::Namespace>(first.path(), first.length());
 }
 
 bool
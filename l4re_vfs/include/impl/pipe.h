@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2026 Kernkonzept GmbH.
+ *
+ * License: see LICENSE.spdx (in this directory or the directories above)
+ */
+#pragma once
+
+#include <l4/sys/semaphore>
+#include <l4/l4re_vfs/backend>
+
+#include "vfs_lock.h"
+
+namespace L4Re { namespace Core {
+
+/**
+ * Control block at the start of the pipe dataspace, followed by the data.
+ *
+ * The ring is a single-producer/single-consumer queue: only the writer
+ * advances `head` and only the reader advances `tail`, both are free-running
+ * byte counters. Before blocking, a side sets its `*_waiting` flag and checks
+ * the ring again. After changing the ring, the peer wakes it through the
+ * corresponding semaphore if the flag is set. The `*_polled` flags work the
+ * same way for select() and poll() within the task of the peer.
+ */
+struct Pipe_ring
+{
+  enum : l4_uint32_t
+  {
+    Magic        = 0x45504950, ///< "PIPE"
+    Data_offset  = 64,         ///< Offset of the data in the dataspace.
+    Default_size = 65536,      ///< Default capacity in bytes.
+  };
+
+  l4_uint32_t magic;
+  /// Capacity in bytes, a power of two.
+  l4_uint32_t size;
+  l4_uint32_t head;
+  l4_uint32_t tail;
+  l4_uint32_t rd_closed;
+  l4_uint32_t wr_closed;
+  l4_uint32_t rd_waiting;
+  l4_uint32_t wr_waiting;
+  l4_uint32_t rd_polled;
+  l4_uint32_t wr_polled;
+
+  char *data()
+  { return reinterpret_cast<char *>(this) + Data_offset; }
+};
+
+/**
+ * Pipe objects shared by the ends of a pipe within one task.
+ */
+class Pipe_channel : public cxx::Ref_obj
+{
+public:
+  void *operator new (size_t size) noexcept
+  { return L4Re::Vfs::vfs_ops->malloc(size); }
+
+  void operator delete (void *m)
+  { L4Re::Vfs::vfs_ops->free(m); }
+
+  /// Take ownership of the capabilities of a pipe.
+  explicit Pipe_channel(L4Re::Vfs::Pipe_caps const &caps) noexcept
+  : _caps(caps), _ring(nullptr), _size(0)
+  {}
+
+  ~Pipe_channel() noexcept;
+
+  /// Attach and check the ring buffer.
+  int attach() noexcept;
+
+  Pipe_ring *ring() const { return _ring; }
+
+  /// Capacity of the ring, checked when attaching.
+  l4_uint32_t size() const { return _size; }
+
+  L4::Cap<L4Re::Dataspace> ring_cap() const { return _caps.ring; }
+
+  L4::Cap<L4::Semaphore> rd_wakeup() const { return _caps.rd_wakeup; }
+  L4::Cap<L4::Semaphore> wr_wakeup() const { return _caps.wr_wakeup; }
+
+  /// Lock serializing the threads using one end.
+  Vfs_lock &lock(bool write_end) { return write_end ? _wr_lock : _rd_lock; }
+
+  /// Allocate the objects of a new pipe.
+  static int create(L4Re::Vfs::Pipe_caps *caps, size_t size) noexcept;
+
+  /// Release the capabilities of a pipe.
+  static void release(L4Re::Vfs::Pipe_caps const &caps) noexcept;
+
+private:
+  L4Re::Vfs::Pipe_caps _caps;
+  Pipe_ring *_ring;
+  l4_uint32_t _size;
+  Vfs_lock _rd_lock;
+  Vfs_lock _wr_lock;
+};
+
+/**
+ * One end of a pipe.
+ */
+class Pipe_end : public L4Re::Vfs::Be_file_stream
+{
+public:
+  Pipe_end(cxx::Ref_ptr<Pipe_channel> const &c, bool write_end,
+           int flags) noexcept;
+  ~Pipe_end() noexcept;
+
+  ssize_t readv(const struct iovec*, int iovcnt) noexcept override;
+  ssize_t writev(const struct iovec*, int iovcnt) noexcept override;
+  int fstat(struct stat64 *buf) const noexcept override;
+  int get_status_flags() const noexcept override;
+  int set_status_flags(long flags) noexcept override;
+  int ioctl(unsigned long request, va_list args) noexcept override;
+  bool check_ready(Ready_type rt) noexcept override;
+
+private:
+  l4_uint32_t avail() const;
+  bool ready() const;
+  void wake_reader();
+  void wake_writer();
+  static int wait(L4::Cap<L4::Semaphore> wakeup);
+
+  cxx::Ref_ptr<Pipe_channel> _c;
+  bool _write_end;
+  bool _nonblock;
+};
+
+}}
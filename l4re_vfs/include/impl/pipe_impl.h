@@ -0,0 +1,436 @@
+/*
+ * Copyright (C) 2026 Kernkonzept GmbH.
+ *
+ * License: see LICENSE.spdx (in this directory or the directories above)
+ */
+
+#include <l4/re/env>
+#include <l4/sys/factory>
+#include <l4/cxx/minmax>
+
+#include "pipe.h"
+
+#include <limits.h>
+#include <sys/ioctl.h>
+
+namespace L4Re { namespace Core {
+
+void
+Pipe_channel::release(L4Re::Vfs::Pipe_caps const &caps) noexcept
+{
+  if (caps.ring.is_valid())
+    L4Re::virt_cap_alloc->release(caps.ring);
+  if (caps.rd_wakeup.is_valid())
+    L4Re::virt_cap_alloc->release(caps.rd_wakeup);
+  if (caps.wr_wakeup.is_valid())
+    L4Re::virt_cap_alloc->release(caps.wr_wakeup);
+}
+
+int
+Pipe_channel::create(L4Re::Vfs::Pipe_caps *caps, size_t size) noexcept
+{
+  if (size > (1UL << 30))
+    return -EINVAL;
+
+  l4_uint32_t sz = PIPE_BUF;
+  while (sz < size)
+    sz <<= 1;
+
+  auto *e = L4Re::Env::env();
+  caps->ring = L4Re::virt_cap_alloc->alloc<L4Re::Dataspace>();
+  caps->rd_wakeup = L4Re::virt_cap_alloc->alloc<L4::Semaphore>();
+  caps->wr_wakeup = L4Re::virt_cap_alloc->alloc<L4::Semaphore>();
+
+  long err = -ENOMEM;
+  if (!caps->ring.is_valid() || !caps->rd_wakeup.is_valid()
+      || !caps->wr_wakeup.is_valid())
+    goto fail;
+
+  err = Vfs_config::allocator()->alloc(l4_round_page(Pipe_ring::Data_offset
+                                                     + sz),
+                                       caps->ring);
+  if (err < 0)
+    goto fail;
+
+  err = l4_error(e->factory()->create(caps->rd_wakeup));
+  if (err < 0)
+    goto fail;
+
+  err = l4_error(e->factory()->create(caps->wr_wakeup));
+  if (err < 0)
+    goto fail;
+
+  {
+    Pipe_ring *r = nullptr;
+    err = e->rm()->attach(&r, L4_PAGESIZE, Rm::F::Search_addr | Rm::F::RW,
+                          caps->ring, 0);
+    if (err < 0)
+      goto fail;
+
+    // The memory is zero-initialized, so the ring is empty and open.
+    r->size = sz;
+    __atomic_store_n(&r->magic, Pipe_ring::Magic, __ATOMIC_RELEASE);
+    e->rm()->detach(l4_addr_t(r), 0);
+  }
+
+  return 0;
+
+fail:
+  release(*caps);
+  return err;
+}
+
+int
+Pipe_channel::attach() noexcept
+{
+  long ds_size = _caps.ring->size();
+  if (ds_size < 0)
+    return ds_size;
+
+  Pipe_ring *r = nullptr;
+  long err = L4Re::Env::env()->rm()->attach(&r, ds_size,
+                                            Rm::F::Search_addr | Rm::F::RW,
+                                            _caps.ring, 0);
+  if (err < 0)
+    return err;
+
+  // The ring may be shared with another task, so check its layout once and
+  // use only the local copy of the size afterwards. The size is valid only
+  // once the magic is visible.
+  l4_uint32_t sz = 0;
+  if (__atomic_load_n(&r->magic, __ATOMIC_ACQUIRE) == Pipe_ring::Magic)
+    sz = __atomic_load_n(&r->size, __ATOMIC_RELAXED);
+
+  if (sz < PIPE_BUF || (sz & (sz - 1))
+      || sz > ds_size - Pipe_ring::Data_offset)
+    {
+      L4Re::Env::env()->rm()->detach(l4_addr_t(r), 0);
+      return -EINVAL;
+    }
+
+  _ring = r;
+  _size = sz;
+  return 0;
+}
+
+Pipe_channel::~Pipe_channel() noexcept
+{
+  if (_ring)
+    L4Re::Env::env()->rm()->detach(l4_addr_t(_ring), 0);
+
+  release(_caps);
+}
+
+Pipe_end::Pipe_end(cxx::Ref_ptr<Pipe_channel> const &c, bool write_end,
+                   int flags) noexcept
+: Be_file_stream(), _c(c), _write_end(write_end),
+  _nonblock(flags & O_NONBLOCK)
+{}
+
+Pipe_end::~Pipe_end() noexcept
+{
+  Pipe_ring *r = _c->ring();
+  if (_write_end)
+    {
+      __atomic_store_n(&r->wr_closed, 1, __ATOMIC_SEQ_CST);
+      wake_reader();
+    }
+  else
+    {
+      __atomic_store_n(&r->rd_closed, 1, __ATOMIC_SEQ_CST);
+      wake_writer();
+    }
+}
+
+l4_uint32_t
+Pipe_end::avail() const
+{
+  Pipe_ring *r = _c->ring();
+  l4_uint32_t n = __atomic_load_n(&r->head, __ATOMIC_SEQ_CST)
+                  - __atomic_load_n(&r->tail, __ATOMIC_SEQ_CST);
+
+  // Do not trust a peer in another task.
+  return cxx::min(n, _c->size());
+}
+
+/**
+ * Block on the wake-up semaphore of this end.
+ *
+ * \retval 0     Woken up or canceled, check the ring again.
+ * \retval -EIO  The semaphore is unusable, e.g. the peer revoked it.
+ */
+int
+Pipe_end::wait(L4::Cap<L4::Semaphore> wakeup)
+{
+  long err = l4_error(wakeup->down());
+  if (err >= 0
+      || err == l4_ipc_to_errno(L4_IPC_RECANCELED)
+      || err == l4_ipc_to_errno(L4_IPC_SECANCELED))
+    return 0;
+
+  return -EIO;
+}
+
+/// Is this end ready for reading or writing, respectively?
+bool
+Pipe_end::ready() const
+{
+  Pipe_ring *r = _c->ring();
+  if (_write_end)
+    return __atomic_load_n(&r->rd_closed, __ATOMIC_SEQ_CST)
+           || _c->size() - avail() >= PIPE_BUF;
+
+  return avail() || __atomic_load_n(&r->wr_closed, __ATOMIC_SEQ_CST);
+}
+
+void
+Pipe_end::wake_reader()
+{
+  Pipe_ring *r = _c->ring();
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&r->rd_waiting, __ATOMIC_RELAXED)
+      && __atomic_exchange_n(&r->rd_waiting, 0, __ATOMIC_ACQ_REL))
+    _c->rd_wakeup()->up();
+
+  // Only pollers in this task can be notified.
+  if (__atomic_load_n(&r->rd_polled, __ATOMIC_RELAXED)
+      && __atomic_exchange_n(&r->rd_polled, 0, __ATOMIC_ACQ_REL))
+    l4re_vfs_select_poll_notify();
+}
+
+void
+Pipe_end::wake_writer()
+{
+  Pipe_ring *r = _c->ring();
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&r->wr_waiting, __ATOMIC_RELAXED)
+      && __atomic_exchange_n(&r->wr_waiting, 0, __ATOMIC_ACQ_REL))
+    _c->wr_wakeup()->up();
+
+  if (__atomic_load_n(&r->wr_polled, __ATOMIC_RELAXED)
+      && __atomic_exchange_n(&r->wr_polled, 0, __ATOMIC_ACQ_REL))
+    l4re_vfs_select_poll_notify();
+}
+
+ssize_t
+Pipe_end::readv(const struct iovec *iovec, int iovcnt) noexcept
+{
+  if (_write_end)
+    return -EBADF;
+
+  if (iovcnt < 0)
+    return -EINVAL;
+
+  size_t total = 0;
+  for (int i = 0; i < iovcnt; ++i)
+    total += cxx::min<size_t>(iovec[i].iov_len, SSIZE_MAX - total);
+
+  if (!total)
+    return 0;
+
+  Vfs_lock::Guard guard(_c->lock(_write_end));
+  if (guard.error())
+    return guard.error();
+
+  Pipe_ring *r = _c->ring();
+
+  size_t n;
+  for (;;)
+    {
+      n = avail();
+      if (n)
+        break;
+
+      if (__atomic_load_n(&r->wr_closed, __ATOMIC_SEQ_CST))
+        {
+          // Data written before closing is still delivered.
+          n = avail();
+          if (!n)
+            return 0;
+          break;
+        }
+
+      if (_nonblock)
+        return -EAGAIN;
+
+      __atomic_store_n(&r->rd_waiting, 1, __ATOMIC_SEQ_CST);
+      if (ready())
+        {
+          __atomic_store_n(&r->rd_waiting, 0, __ATOMIC_RELAXED);
+          continue;
+        }
+
+      if (int err = wait(_c->rd_wakeup()))
+        {
+          __atomic_store_n(&r->rd_waiting, 0, __ATOMIC_RELAXED);
+          return err;
+        }
+    }
+
+  n = cxx::min(n, total);
+
+  l4_uint32_t mask = _c->size() - 1;
+  l4_uint32_t tail = __atomic_load_n(&r->tail, __ATOMIC_RELAXED);
+  size_t done = 0;
+  for (; done < n; ++iovec)
+    {
+      size_t l = cxx::min(iovec->iov_len, n - done);
+      char *dst = static_cast<char *>(iovec->iov_base);
+      l4_uint32_t offs = (tail + done) & mask;
+      size_t first = cxx::min<size_t>(l, mask + 1 - offs);
+
+      Vfs_config::memcpy(dst, r->data() + offs, first);
+      Vfs_config::memcpy(dst + first, r->data(), l - first);
+      done += l;
+    }
+
+  __atomic_store_n(&r->tail, tail + n, __ATOMIC_RELEASE);
+  wake_writer();
+  return n;
+}
+
+ssize_t
+Pipe_end::writev(const struct iovec *iovec, int iovcnt) noexcept
+{
+  if (!_write_end)
+    return -EBADF;
+
+  if (iovcnt < 0)
+    return -EINVAL;
+
+  size_t total = 0;
+  for (int i = 0; i < iovcnt; ++i)
+    total += cxx::min<size_t>(iovec[i].iov_len, SSIZE_MAX - total);
+
+  if (!total)
+    return 0;
+
+  // Writes of at most PIPE_BUF bytes are not interleaved with other writes.
+  bool atomic = total <= PIPE_BUF;
+
+  Vfs_lock::Guard guard(_c->lock(_write_end));
+  if (guard.error())
+    return guard.error();
+
+  Pipe_ring *r = _c->ring();
+  l4_uint32_t mask = _c->size() - 1;
+
+  size_t done = 0;
+  size_t iov_offs = 0;
+  while (done < total)
+    {
+      if (__atomic_load_n(&r->rd_closed, __ATOMIC_SEQ_CST))
+        return done ? static_cast<ssize_t>(done) : -EPIPE;
+
+      size_t space = _c->size() - avail();
+      if (space < (atomic ? total : 1))
+        {
+          if (_nonblock)
+            return done ? static_cast<ssize_t>(done) : -EAGAIN;
+
+          __atomic_store_n(&r->wr_waiting, 1, __ATOMIC_SEQ_CST);
+          if (_c->size() - avail() >= (atomic ? total : 1)
+              || __atomic_load_n(&r->rd_closed, __ATOMIC_SEQ_CST))
+            {
+              __atomic_store_n(&r->wr_waiting, 0, __ATOMIC_RELAXED);
+              continue;
+            }
+
+          if (int err = wait(_c->wr_wakeup()))
+            {
+              __atomic_store_n(&r->wr_waiting, 0, __ATOMIC_RELAXED);
+              return done ? static_cast<ssize_t>(done) : err;
+            }
+          continue;
+        }
+
+      size_t n = cxx::min(space, total - done);
+      l4_uint32_t head = __atomic_load_n(&r->head, __ATOMIC_RELAXED);
+      for (size_t copied = 0; copied < n;)
+        {
+          size_t l = cxx::min(iovec->iov_len - iov_offs, n - copied);
+          char const *src = static_cast<char const *>(iovec->iov_base)
+                            + iov_offs;
+          l4_uint32_t offs = (head + copied) & mask;
+          size_t first = cxx::min<size_t>(l, mask + 1 - offs);
+
+          Vfs_config::memcpy(r->data() + offs, src, first);
+          Vfs_config::memcpy(r->data(), src + first, l - first);
+          copied += l;
+          iov_offs += l;
+          if (iov_offs == iovec->iov_len)
+            {
+              ++iovec;
+              iov_offs = 0;
+            }
+        }
+
+      __atomic_store_n(&r->head, head + n, __ATOMIC_RELEASE);
+      wake_reader();
+      done += n;
+    }
+
+  return done;
+}
+
+int
+Pipe_end::fstat(struct stat64 *buf) const noexcept
+{
+  memset(buf, 0, sizeof(*buf));
+  buf->st_mode = S_IFIFO | 0600;
+  buf->st_dev = _c->ring_cap().cap();
+  buf->st_blksize = PIPE_BUF;
+  return 0;
+}
+
+int
+Pipe_end::get_status_flags() const noexcept
+{
+  return (_write_end ? O_WRONLY : O_RDONLY) | (_nonblock ? O_NONBLOCK : 0);
+}
+
+int
+Pipe_end::set_status_flags(long flags) noexcept
+{
+  _nonblock = flags & O_NONBLOCK;
+  return 0;
+}
+
+int
+Pipe_end::ioctl(unsigned long request, va_list args) noexcept
+{
+  switch (request)
+    {
+    case FIONREAD:
+      *va_arg(args, int *) = _write_end ? 0 : avail();
+      return 0;
+
+    case FIONBIO:
+      _nonblock = *va_arg(args, int *);
+      return 0;
+
+    default:
+      return -ENOTTY;
+    }
+}
+
+bool
+Pipe_end::check_ready(Ready_type rt) noexcept
+{
+  Pipe_ring *r = _c->ring();
+  if (rt == Exception)
+    return _write_end && __atomic_load_n(&r->rd_closed, __ATOMIC_SEQ_CST);
+
+  if ((rt == Write) != _write_end)
+    return false;
+
+  if (ready())
+    return true;
+
+  // Ask the peer for a notification and check again to not miss it.
+  __atomic_store_n(_write_end ? &r->wr_polled : &r->rd_polled, 1,
+                   __ATOMIC_SEQ_CST);
+  return ready();
+}
+
+}}
@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2026 Kernkonzept GmbH.
+ *
+ * License: see LICENSE.spdx (in this directory or the directories above)
+ */
+#pragma once
+
+#include <l4/l4re_vfs/backend>
+#include <l4/re/namespace>
+
+#include <limits.h>
+
+namespace L4Re { namespace Core {
+
+using cxx::Ref_ptr;
+
+/**
+ * Directory of the POSIX shared memory objects of the task.
+ *
+ * An object is a dataspace allocated from the memory allocator of the task
+ * and registered under its name in the name space `shm` of the environment.
+ * All tasks that get the same name space share the objects. Without such a
+ * name space, a private one is created and the objects are only visible
+ * within the task.
+ *
+ * Dataspaces cannot be resized, so a new object gets its dataspace by the
+ * first ftruncate() and only then becomes visible to other openers.
+ *
+ * The lifetime of the memory differs from POSIX. The dataspace is accounted
+ * to the memory allocator of the task that called that ftruncate(). Neither
+ * shm_unlink() nor closing and unmapping the object frees it. The memory
+ * remains allocated as long as this allocator exists, usually until the
+ * creating task exits. The object then disappears for all other tasks as
+ * well, including their mappings.
+ */
+class Shm_dir : public L4Re::Vfs::Be_file
+{
+public:
+  Shm_dir() noexcept : _ns(L4_INVALID_CAP) {}
+
+  ssize_t readv(const struct iovec*, int) noexcept override { return -EISDIR; }
+  ssize_t writev(const struct iovec*, int) noexcept override { return -EISDIR; }
+  ssize_t preadv(const struct iovec*, int, off64_t) noexcept override { return -EISDIR; }
+  ssize_t pwritev(const struct iovec*, int, off64_t) noexcept override { return -EISDIR; }
+  int fstat(struct stat64 *) const noexcept override;
+  int faccessat(const char *path, int mode, int flags) noexcept override;
+  int get_entry(const char *path, int flags, mode_t mode,
+                Ref_ptr<L4Re::Vfs::File> *) noexcept override;
+  int unlink(const char *path) noexcept override;
+
+  ~Shm_dir() noexcept {}
+
+private:
+  int name_space(L4::Cap<L4Re::Namespace> *ns) noexcept;
+
+  l4_cap_idx_t _ns;
+};
+
+/**
+ * An open POSIX shared memory object.
+ */
+class Shm_file : public L4Re::Vfs::Be_file
+{
+public:
+  /**
+   * \param ns     Name space the object is registered in.
+   * \param name   Name of the object.
+   * \param ds     Dataspace of the object, invalid for an object that still
+   *               needs to be sized. The file takes ownership.
+   * \param flags  Open flags.
+   */
+  Shm_file(L4::Cap<L4Re::Namespace> ns, char const *name,
+           L4::Cap<L4Re::Dataspace> ds, int flags) noexcept;
+  ~Shm_file() noexcept;
+
+  L4::Cap<L4Re::Dataspace> data_space() noexcept override
+  { return L4::Cap<L4Re::Dataspace>(__atomic_load_n(&_ds, __ATOMIC_ACQUIRE)); }
+
+  int fstat(struct stat64 *buf) const noexcept override;
+  int ftruncate(off64_t length) noexcept override;
+  int get_status_flags() const noexcept override;
+
+private:
+  int publish(off64_t length) noexcept;
+
+  L4::Cap<L4Re::Namespace> _ns;
+  l4_cap_idx_t _ds;
+  int _flags;
+  char _name[NAME_MAX + 1];
+};
+
+}}
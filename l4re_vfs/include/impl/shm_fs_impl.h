@@ -0,0 +1,292 @@
+/*
+ * Copyright (C) 2026 Kernkonzept GmbH.
+ *
+ * License: see LICENSE.spdx (in this directory or the directories above)
+ */
+
+#include <l4/re/dataspace>
+#include <l4/re/env>
+#include <l4/re/mem_alloc>
+#include <l4/re/unique_cap>
+#include <l4/sys/factory>
+
+#include "shm_fs.h"
+
+namespace L4Re { namespace Core {
+
+static int
+shm_error(long err)
+{
+  switch (err)
+    {
+    case -L4_ENOENT:  return -ENOENT;
+    case -L4_EEXIST:  return -EEXIST;
+    case -L4_ENOMEM:  return -ENOMEM;
+    case -L4_ENOSYS:  return -ENOSYS;
+    case -L4_EPERM:
+    case -L4_EACCESS: return -EACCES;
+    default:          return -EIO;
+    }
+}
+
+int
+Shm_dir::name_space(L4::Cap<L4Re::Namespace> *ns) noexcept
+{
+  l4_cap_idx_t c = __atomic_load_n(&_ns, __ATOMIC_ACQUIRE);
+  if (!l4_is_invalid_cap(c))
+    {
+      *ns = L4::Cap<L4Re::Namespace>(c);
+      return 0;
+    }
+
+  auto *e = L4Re::Env::env();
+  L4::Cap<L4Re::Namespace> shared = e->get_cap<L4Re::Namespace>("shm");
+  if (shared.is_valid())
+    {
+      __atomic_store_n(&_ns, shared.cap(), __ATOMIC_RELEASE);
+      *ns = shared;
+      return 0;
+    }
+
+  auto priv = L4Re::make_unique_cap<L4Re::Namespace>(L4Re::virt_cap_alloc);
+  if (!priv.is_valid())
+    return -ENOMEM;
+
+  // The kernel factory cannot create name spaces, the user factory (moe)
+  // can.
+  long err = l4_error(e->user_factory()->create(priv.get()));
+  if (err < 0)
+    return shm_error(err);
+
+  // Another thread may have been faster, then use its name space.
+  if (!__atomic_compare_exchange_n(&_ns, &c, priv.get().cap(), false,
+                                   __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+    {
+      *ns = L4::Cap<L4Re::Namespace>(c);
+      return 0;
+    }
+
+  *ns = priv.release();
+  return 0;
+}
+
+int
+Shm_dir::get_entry(const char *path, int flags, mode_t /*mode*/,
+                   Ref_ptr<L4Re::Vfs::File> *f) noexcept
+{
+  if (!*path)
+    {
+      *f = cxx::ref_ptr(this);
+      return 0;
+    }
+
+  size_t len = 0;
+  for (; path[len]; ++len)
+    if (path[len] == '/')
+      return -EINVAL;
+
+  if (len > NAME_MAX)
+    return -ENAMETOOLONG;
+
+  L4::Cap<L4Re::Namespace> ns;
+  int err = name_space(&ns);
+  if (err < 0)
+    return err;
+
+  auto ds = L4Re::make_unique_cap<L4Re::Dataspace>(L4Re::virt_cap_alloc);
+  if (!ds.is_valid())
+    return -ENOMEM;
+
+  long r = ns->query(path, ds.get());
+  if (r < 0 && r != -L4_ENOENT)
+    return shm_error(r);
+
+  if (r >= 0)
+    {
+      if ((flags & O_CREAT) && (flags & O_EXCL))
+        return -EEXIST;
+
+      // Truncation yields a new object that replaces the current one once
+      // it is sized. Existing mappings keep the old one.
+      if ((flags & O_TRUNC) && (flags & O_ACCMODE) != O_RDONLY)
+        ds.reset();
+    }
+  else
+    {
+      if (!(flags & O_CREAT))
+        return -ENOENT;
+
+      ds.reset();
+    }
+
+  Ref_ptr<L4Re::Vfs::File> fi(new Shm_file(ns, path, ds.get(), flags));
+  if (!fi)
+    return -ENOMEM;
+
+  ds.release();
+  *f = cxx::move(fi);
+  return 0;
+}
+
+int
+Shm_dir::faccessat(const char *path, int /*mode*/, int /*flags*/) noexcept
+{
+  L4::Cap<L4Re::Namespace> ns;
+  int err = name_space(&ns);
+  if (err < 0)
+    return err;
+
+  auto tmp = L4Re::make_unique_cap<void>(L4Re::virt_cap_alloc);
+  if (!tmp.is_valid())
+    return -ENOMEM;
+
+  long r = ns->query(path, tmp.get());
+  return r < 0 ? shm_error(r) : 0;
+}
+
+int
+Shm_dir::unlink(const char *path) noexcept
+{
+  L4::Cap<L4Re::Namespace> ns;
+  int err = name_space(&ns);
+  if (err < 0)
+    return err;
+
+  // Only removes the name, the memory stays allocated, see Shm_dir.
+  long r = ns->unlink(path);
+  return r < 0 ? shm_error(r) : 0;
+}
+
+int
+Shm_dir::fstat(struct stat64 *b) const noexcept
+{
+  memset(b, 0, sizeof(*b));
+  b->st_dev = 1;
+  b->st_ino = 1;
+  b->st_mode = S_IFDIR | S_ISVTX | S_IRWXU | S_IRWXG | S_IRWXO;
+  return 0;
+}
+
+Shm_file::Shm_file(L4::Cap<L4Re::Namespace> ns, char const *name,
+                   L4::Cap<L4Re::Dataspace> ds, int flags) noexcept
+: Be_file(), _ns(ns), _ds(ds.cap()), _flags(flags)
+{
+  size_t l = strlen(name);
+  Vfs_config::memcpy(_name, name, l + 1);
+}
+
+Shm_file::~Shm_file() noexcept
+{
+  L4::Cap<L4Re::Dataspace> ds = data_space();
+  if (ds.is_valid())
+    L4Re::virt_cap_alloc->release(ds);
+}
+
+int
+Shm_file::fstat(struct stat64 *buf) const noexcept
+{
+  L4::Cap<L4Re::Dataspace> ds(__atomic_load_n(&_ds, __ATOMIC_ACQUIRE));
+
+  memset(buf, 0, sizeof(*buf));
+  buf->st_mode = S_IFREG | S_IRUSR | S_IWUSR;
+  buf->st_dev = _ns.cap();
+  buf->st_ino = ds.cap();
+  buf->st_nlink = 1;
+  buf->st_blksize = L4_PAGESIZE;
+  if (ds.is_valid())
+    {
+      buf->st_size = ds->size();
+      buf->st_blocks = l4_round_page(buf->st_size) / 512;
+    }
+  return 0;
+}
+
+int
+Shm_file::get_status_flags() const noexcept
+{
+  return _flags & O_ACCMODE;
+}
+
+/**
+ * Allocate the dataspace of a new object and register it.
+ *
+ * If another task or thread was faster, its dataspace is used instead.
+ * Otherwise the memory is charged to the allocator of this task for the
+ * lifetime of the allocator, see Shm_dir.
+ */
+int
+Shm_file::publish(off64_t length) noexcept
+{
+  if (length > LONG_MAX)
+    return -EFBIG;
+
+  auto ds = L4Re::make_unique_cap<L4Re::Dataspace>(L4Re::virt_cap_alloc);
+  if (!ds.is_valid())
+    return -ENOMEM;
+
+  // Allow large objects to be backed and mapped by superpages.
+  unsigned long alloc_flags = 0;
+  unsigned long align = 0;
+  if (length >= L4_SUPERPAGESIZE)
+    {
+      alloc_flags = L4Re::Mem_alloc::Super_pages;
+      align = L4_SUPERPAGESHIFT;
+    }
+
+  long err = Vfs_config::allocator()->alloc(length, ds.get(), alloc_flags,
+                                            align);
+  if (err < 0)
+    return err == -L4_ERANGE ? -EFBIG : -ENOMEM;
+
+  unsigned reg_flags = L4Re::Namespace::Rw;
+  if (_flags & O_TRUNC)
+    reg_flags |= L4Re::Namespace::Overwrite;
+
+  err = _ns->register_obj(_name, ds.get(), reg_flags);
+  if (err == -L4_EEXIST)
+    {
+      ds = L4Re::make_unique_cap<L4Re::Dataspace>(L4Re::virt_cap_alloc);
+      if (!ds.is_valid())
+        return -ENOMEM;
+
+      err = _ns->query(_name, ds.get());
+    }
+
+  if (err < 0)
+    return shm_error(err);
+
+  l4_cap_idx_t none = L4_INVALID_CAP;
+  if (__atomic_compare_exchange_n(&_ds, &none, ds.get().cap(), false,
+                                  __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+    ds.release();
+
+  return 0;
+}
+
+int
+Shm_file::ftruncate(off64_t length) noexcept
+{
+  if (length < 0 || (_flags & O_ACCMODE) == O_RDONLY)
+    return -EINVAL;
+
+  L4::Cap<L4Re::Dataspace> ds = data_space();
+  if (!ds.is_valid())
+    {
+      if (!length)
+        return 0;
+
+      int err = publish(length);
+      if (err < 0)
+        return err;
+
+      ds = data_space();
+    }
+
+  // Dataspaces cannot grow, shrinking is ignored.
+  if (length > ds->size())
+    return -EFBIG;
+
+  return 0;
+}
+
+}}
@@ -10,6 +10,8 @@
 #include "fd_store.h"
 #include "vcon_stream.h"
 #include "ns_fs.h"
+#include "pipe.h"
+#include "shm_fs.h"
 
 #include <l4/bid_config.h>
 #include <l4/re/env>
@@ -99,6 +101,7 @@ public:
   {
     _root_mount.add_ref();
     _root.add_ref();
+    _shm.add_ref();
     _root_mount.mount(cxx::ref_ptr(&_root));
     _cwd = cxx::ref_ptr(&_root);
 
@@ -142,6 +145,14 @@ public:
   Ref_ptr<L4Re::Vfs::File_factory> get_file_factory(char const *proto_name) noexcept override;
   int mount(char const *path, cxx::Ref_ptr<L4Re::Vfs::File> const &dir) noexcept override;
 
+  int pipe2(int pipefd[2], int flags) noexcept override;
+  int pipe_create(L4Re::Vfs::Pipe_caps *caps, size_t size) noexcept override;
+  int pipe_open(L4Re::Vfs::Pipe_caps const &caps, bool write_end,
+                int flags) noexcept override;
+
+  int shm_open(char const *name, int oflag, mode_t mode) noexcept override;
+  int shm_unlink(char const *name) noexcept override;
+
   void operator delete (void *) {}
 
   void *malloc(size_t size) noexcept override { return Vfs_config::malloc(size); }
@@ -150,6 +161,7 @@ public:
 private:
   Root_mount_tree _root_mount;
   L4Re::Core::Env_dir _root;
+  L4Re::Core::Shm_dir _shm;
   Ref_ptr<L4Re::Vfs::File> _cwd;
   Fd_store fds;
 
@@ -340,6 +352,123 @@ Vfs::free_fd(int fd) noexcept
   return f;
 }
 
+int
+Vfs::pipe_create(L4Re::Vfs::Pipe_caps *caps, size_t size) noexcept
+{
+  return L4Re::Core::Pipe_channel::create(caps, size);
+}
+
+int
+Vfs::pipe_open(L4Re::Vfs::Pipe_caps const &caps, bool write_end,
+               int flags) noexcept
+{
+  using L4Re::Core::Pipe_channel;
+
+  // O_CLOEXEC holds for every descriptor, there is no working exec().
+  if (flags & ~(O_NONBLOCK | O_CLOEXEC))
+    {
+      Pipe_channel::release(caps);
+      return -EINVAL;
+    }
+
+  Pipe_channel *c = new Pipe_channel(caps);
+  if (!c)
+    {
+      Pipe_channel::release(caps);
+      return -ENOMEM;
+    }
+
+  // The channel owns the capabilities from now on.
+  Ref_ptr<Pipe_channel> cp(c);
+  int err = c->attach();
+  if (err < 0)
+    return err;
+
+  Ref_ptr<L4Re::Vfs::File> f(new L4Re::Core::Pipe_end(cp, write_end, flags));
+  if (!f)
+    return -ENOMEM;
+
+  return alloc_fd(f);
+}
+
+int
+Vfs::pipe2(int pipefd[2], int flags) noexcept
+{
+  using L4Re::Core::Pipe_channel;
+  using L4Re::Core::Pipe_end;
+  using L4Re::Core::Pipe_ring;
+
+  // O_CLOEXEC holds for every descriptor, there is no working exec().
+  if (flags & ~(O_NONBLOCK | O_CLOEXEC))
+    return -EINVAL;
+
+  L4Re::Vfs::Pipe_caps caps;
+  int err = Pipe_channel::create(&caps, Pipe_ring::Default_size);
+  if (err < 0)
+    return err;
+
+  Pipe_channel *c = new Pipe_channel(caps);
+  if (!c)
+    {
+      Pipe_channel::release(caps);
+      return -ENOMEM;
+    }
+
+  Ref_ptr<Pipe_channel> cp(c);
+  err = c->attach();
+  if (err < 0)
+    return err;
+
+  Ref_ptr<L4Re::Vfs::File> rd(new Pipe_end(cp, false, flags));
+  Ref_ptr<L4Re::Vfs::File> wr(new Pipe_end(cp, true, flags));
+  if (!rd || !wr)
+    return -ENOMEM;
+
+  int rfd = alloc_fd(rd);
+  if (rfd < 0)
+    return rfd;
+
+  int wfd = alloc_fd(wr);
+  if (wfd < 0)
+    {
+      free_fd(rfd);
+      return wfd;
+    }
+
+  pipefd[0] = rfd;
+  pipefd[1] = wfd;
+  return 0;
+}
+
+int
+Vfs::shm_open(char const *name, int oflag, mode_t mode) noexcept
+{
+  while (*name == '/')
+    ++name;
+
+  if (!*name)
+    return -EINVAL;
+
+  Ref_ptr<L4Re::Vfs::File> f;
+  int err = _shm.get_entry(name, oflag, mode, &f);
+  if (err < 0)
+    return err;
+
+  return alloc_fd(f);
+}
+
+int
+Vfs::shm_unlink(char const *name) noexcept
+{
+  while (*name == '/')
+    ++name;
+
+  if (!*name)
+    return -EINVAL;
+
+  return _shm.unlink(name);
+}
+
 
 Ref_ptr<L4Re::Vfs::File>
 Vfs::get_root() noexcept
@@ -598,12 +727,23 @@ Vfs::mmap2(void *start, size_t len, int prot, int flags, int fd, off_t page4k_of
   if (prot & PROT_EXEC)
     rm_flags |= Rm::F::X;
 
+  // Locked mappings are mapped completely right away and then stay resident.
+  if (flags & (MAP_LOCKED | MAP_POPULATE))
+    rm_flags |= Rm::F::Eager_map;
+
+  // Let large mappings of a dataspace use superpages where the offset
+  // allows it.
+  unsigned char align = L4_PAGESHIFT;
+  if (ds.is_valid() && !(flags & MAP_FIXED) && len >= L4_SUPERPAGESIZE
+      && !(offset & (L4_SUPERPAGESIZE - 1)))
+    align = L4_SUPERPAGESHIFT;
+
   // Region manager takes a reference to the ds cap...
   err = r->attach(&data, len, rm_flags,
                   L4::Ipc::make_cap(ds, (prot & PROT_WRITE)
                                         ? L4_CAP_FPAGE_RW
                                         : L4_CAP_FPAGE_RO),
-                  offset, L4_PAGESHIFT, L4::Cap<L4::Task>::Invalid,
+                  offset, align, L4::Cap<L4::Task>::Invalid,
                   region_name, file_offset);
 
   DEBUG_LOG(debug_mmap, {
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2026 Kernkonzept GmbH.
+ *
+ * License: see LICENSE.spdx (in this directory or the directories above)
+ */
+#pragma once
+
+#include <l4/sys/semaphore>
+
+namespace L4Re { namespace Core {
+
+/**
+ * Mutex that does not depend on libpthread, which is not available in ldso.
+ *
+ * Locking without contention makes no syscall. Contending threads block on a
+ * kernel semaphore, which is created by the first thread that has to wait.
+ */
+class Vfs_lock
+{
+public:
+  class Guard
+  {
+  public:
+    explicit Guard(Vfs_lock &l) : _l(l), _err(l.lock()) {}
+    ~Guard() { if (!_err) _l.unlock(); }
+
+    /// 0 if the lock is held, otherwise the error of Vfs_lock::lock().
+    int error() const { return _err; }
+
+    Guard(Guard const &) = delete;
+    Guard &operator = (Guard const &) = delete;
+
+  private:
+    Vfs_lock &_l;
+    int _err;
+  };
+
+  Vfs_lock() noexcept : _users(0), _sem(L4_INVALID_CAP) {}
+  ~Vfs_lock() noexcept;
+
+  /**
+   * Acquire the lock.
+   *
+   * \retval 0        The lock is held.
+   * \retval -ENOMEM  No semaphore to wait on could be created.
+   * \retval -EIO     Waiting on the semaphore failed.
+   *
+   * The lock is not held if an error is returned.
+   */
+  int lock() noexcept
+  {
+    l4_uint32_t free = 0;
+    if (__atomic_compare_exchange_n(&_users, &free, 1, false,
+                                    __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+      return 0;
+
+    return lock_contended();
+  }
+
+  void unlock() noexcept
+  {
+    // A waiter creates the semaphore before it registers itself.
+    if (__atomic_fetch_sub(&_users, 1, __ATOMIC_ACQ_REL) > 1)
+      sem()->up();
+  }
+
+private:
+  int lock_contended() noexcept;
+
+  L4::Cap<L4::Semaphore> sem() const noexcept
+  { return L4::Cap<L4::Semaphore>(__atomic_load_n(&_sem, __ATOMIC_ACQUIRE)); }
+
+  l4_uint32_t _users;
+  l4_cap_idx_t _sem;
+};
+
+}}
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2026 Kernkonzept GmbH.
+ *
+ * License: see LICENSE.spdx (in this directory or the directories above)
+ */
+
+#include <l4/re/env>
+#include <l4/sys/factory>
+
+#include "vfs_lock.h"
+
+#include <errno.h>
+
+namespace L4Re { namespace Core {
+
+Vfs_lock::~Vfs_lock() noexcept
+{
+  L4::Cap<L4::Semaphore> s = sem();
+  if (s.is_valid())
+    L4Re::virt_cap_alloc->release(s);
+}
+
+int
+Vfs_lock::lock_contended() noexcept
+{
+  if (!sem().is_valid())
+    {
+      L4::Cap<L4::Semaphore> s = L4Re::virt_cap_alloc->alloc<L4::Semaphore>();
+      if (!s.is_valid())
+        return -ENOMEM;
+
+      if (l4_error(L4Re::Env::env()->factory()->create(s)) < 0)
+        {
+          L4Re::virt_cap_alloc->free(s);
+          return -ENOMEM;
+        }
+
+      // Another waiter may have been faster, then use its semaphore.
+      l4_cap_idx_t none = L4_INVALID_CAP;
+      if (!__atomic_compare_exchange_n(&_sem, &none, s.cap(), false,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        L4Re::virt_cap_alloc->release(s);
+    }
+
+  if (!__atomic_fetch_add(&_users, 1, __ATOMIC_ACQUIRE))
+    return 0;
+
+  for (;;)
+    {
+      long err = l4_error(sem()->down());
+      if (err >= 0)
+        return 0;
+
+      // A canceled down() did not take the wake-up of the owner, wait again.
+      if (err == l4_ipc_to_errno(L4_IPC_RECANCELED)
+          || err == l4_ipc_to_errno(L4_IPC_SECANCELED))
+        continue;
+
+      // The semaphore is unusable, e.g. it was revoked.
+      __atomic_fetch_sub(&_users, 1, __ATOMIC_RELAXED);
+      return -EIO;
+    }
+}
+
+}}
@@ -28,6 +28,7 @@
 #include <l4/sys/capability>
 #include <l4/re/cap_alloc>
 #include <l4/re/dataspace>
+#include <l4/sys/semaphore>
 #include <l4/cxx/pair>
 #include <l4/cxx/ref_ptr>
 
@@ -935,6 +936,24 @@ private:
   File_system *_head;
 };
 
+/**
+ * Capabilities of a pipe.
+ *
+ * A pipe consists of a dataspace holding a ring buffer and two semaphores
+ * for waking up the reader and the writer. To share a pipe between tasks,
+ * map the capabilities to the other task and open one end in each task with
+ * Fs::pipe_open().
+ */
+struct Pipe_caps
+{
+  /// Ring buffer of the pipe.
+  L4::Cap<L4Re::Dataspace> ring;
+  /// Semaphore the reader waits on.
+  L4::Cap<L4::Semaphore> rd_wakeup;
+  /// Semaphore the writer waits on.
+  L4::Cap<L4::Semaphore> wr_wakeup;
+};
+
 /**
  * \brief POSIX File-system related functionality.
  * \note This class usually exists as a singleton and as a superclass
@@ -1044,6 +1063,74 @@ public:
   virtual cxx::Ref_ptr<File_factory> get_file_factory(int proto) noexcept = 0;
   virtual cxx::Ref_ptr<File_factory> get_file_factory(char const *proto_name) noexcept = 0;
 
+  /**
+   * Backend for the POSIX pipe2 call.
+   *
+   * \param[out] pipefd  File descriptors of the read end (pipefd[0]) and of
+   *                     the write end (pipefd[1]).
+   * \param      flags   O_NONBLOCK and/or O_CLOEXEC.
+   *
+   * \return 0 on success, <0 on error.
+   *
+   * O_CLOEXEC needs no action: exec() always fails on L4Re, so no
+   * descriptor ever survives it.
+   */
+  virtual int pipe2(int pipefd[2], int flags) noexcept = 0;
+
+  /**
+   * Create the objects of a pipe without opening it.
+   *
+   * \param[out] caps  Capabilities of the pipe, allocated from
+   *                   L4Re::virt_cap_alloc. The caller owns them.
+   * \param      size  Minimum capacity of the pipe in bytes.
+   *
+   * \return 0 on success, <0 on error.
+   */
+  virtual int pipe_create(Pipe_caps *caps, size_t size) noexcept = 0;
+
+  /**
+   * Open one end of a pipe created by pipe_create(), e.g., in another task.
+   *
+   * \param caps       Capabilities of the pipe, allocated from
+   *                   L4Re::virt_cap_alloc. The opened file takes ownership
+   *                   of them, they are also released if opening fails.
+   * \param write_end  Open the write end if true, the read end otherwise.
+   * \param flags      O_NONBLOCK and/or O_CLOEXEC, see pipe2().
+   *
+   * \return The file descriptor on success, <0 on error.
+   *
+   * Each end of a pipe shall be open in one task only.
+   */
+  virtual int pipe_open(Pipe_caps const &caps, bool write_end,
+                        int flags) noexcept = 0;
+
+  /**
+   * Backend for the POSIX shm_open call.
+   *
+   * \param name   Name of the shared memory object. Leading slashes are
+   *               ignored, no other slash is allowed.
+   * \param oflag  O_RDONLY or O_RDWR, optionally with O_CREAT, O_EXCL and
+   *               O_TRUNC.
+   * \param mode   Permissions of a new object.
+   *
+   * \return The file descriptor on success, <0 on error.
+   *
+   * Objects are dataspaces registered in the name space `shm` of the
+   * environment, or in a name space private to the task if there is none. A
+   * new object needs to be sized with ftruncate() before it can be mapped or
+   * opened by others, and it cannot be resized afterwards.
+   */
+  virtual int shm_open(char const *name, int oflag, mode_t mode) noexcept = 0;
+
+  /**
+   * Backend for the POSIX shm_unlink call.
+   *
+   * \param name  Name of the shared memory object.
+   *
+   * \return 0 on success, <0 on error.
+   */
+  virtual int shm_unlink(char const *name) noexcept = 0;
+
   virtual ~Fs() = 0;
 
 private:
@@ -29,10 +29,13 @@ load_module(char const *)
 
 }
 
+#include <l4/l4re_vfs/impl/vfs_lock_impl.h>
 #include <l4/l4re_vfs/impl/ns_fs_impl.h>
 #include <l4/l4re_vfs/impl/ro_file_impl.h>
 #include <l4/l4re_vfs/impl/fd_store_impl.h>
 #include <l4/l4re_vfs/impl/vcon_stream_impl.h>
+#include <l4/l4re_vfs/impl/pipe_impl.h>
+#include <l4/l4re_vfs/impl/shm_fs_impl.h>
 #include <l4/l4re_vfs/impl/vfs_impl.h>
 // must be the last
 #include <l4/l4re_vfs/impl/default_ops_impl.h>
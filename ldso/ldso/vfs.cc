@@ -158,10 +158,29 @@ extern "C" void __aeabi_atexit(void)
 {}
 #endif
 
+// select() and poll() live in the libc backend, which is loaded after us.
+extern "C"
+void l4re_vfs_select_poll_notify(void)
+{
+  typedef void Notify(void);
+  static Notify *notify;
+
+  if (!notify)
+    notify = reinterpret_cast<Notify *>(
+               _dl_find_hash("l4re_vfs_select_poll_notify", _dl_symbol_tables,
+                             NULL, ELF_RTYPE_CLASS_PLT, NULL));
+
+  if (notify)
+    notify();
+}
+
+#include <l4/l4re_vfs/impl/vfs_lock_impl.h>
 #include <l4/l4re_vfs/impl/ns_fs_impl.h>
 #include <l4/l4re_vfs/impl/ro_file_impl.h>
 #include <l4/l4re_vfs/impl/fd_store_impl.h>
 #include <l4/l4re_vfs/impl/vcon_stream_impl.h>
+#include <l4/l4re_vfs/impl/pipe_impl.h>
+#include <l4/l4re_vfs/impl/shm_fs_impl.h>
 #include <l4/l4re_vfs/impl/vfs_impl.h>
 // must be the last
 #include <l4/l4re_vfs/impl/default_ops_impl.h>
@@ -21,8 +21,9 @@
 #define FLOCK(f)
 #define FUNLOCK(f)
 #else
-// TODO: Add optimized implementation, that avoids unnecessary overhead of pthread_mutex, if it has any.
-#define FILE_LOCK_INITIALIZER (pthread_mutex_t) {0, 0, 0, PTHREAD_MUTEX_RECURSIVE_NP, __LOCK_INITIALIZER}
+// Recursion is handled by __lockfile() through the owner of the FILE, so the
+// mutex can be the adaptive kind, whose uncontended path is a single CAS.
+#define FILE_LOCK_INITIALIZER (pthread_mutex_t) {0, 0, 0, PTHREAD_MUTEX_ADAPTIVE_NP, __LOCK_INITIALIZER}
 #define FILE_LOCK_INITIALIZE(f)          \
   do                                     \
     {                                    \
@@ -30,6 +31,7 @@
         (f)->needs_lock = -1;            \
                                          \
       (f)->lock = FILE_LOCK_INITIALIZER; \
+      (f)->owner = 0;                    \
     }                                    \
   while (0)
 #define FFINALLOCK(f) ((f)->needs_lock>=0 ? __lockfile((f)) : 0)
@@ -67,6 +69,8 @@ struct _IO_FILE {
 #ifndef L4_MINIMAL_LIBC
 	// TODO: Need to initialize?!
 	pthread_mutex_t lock;
+	// Thread descriptor of the thread holding lock, if any.
+	void *volatile owner;
 #endif
 	int lbf;
 	void *cookie;
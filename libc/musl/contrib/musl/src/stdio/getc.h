@@ -38,10 +38,10 @@ static inline int do_getc(FILE *f)
 	if (f->needs_lock < 0)
 		return getc_unlocked(f);
 
-	// TODO: Optimize the case that we already hold the lock?
-	pthread_mutex_lock(&f->lock);
+	int need_unlock = __lockfile(f);
 	int r = getc_unlocked(f);
-	pthread_mutex_unlock(&f->lock);
+	if (need_unlock)
+		__unlockfile(f);
 	return r;
 }
 
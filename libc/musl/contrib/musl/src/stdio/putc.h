@@ -37,10 +37,10 @@ static inline int do_putc(int c, FILE *f)
 	if (f->needs_lock < 0)
 		return putc_unlocked(c, f);
 
-	// TODO: Optimize the case that we already hold the lock?
-	pthread_mutex_lock(&f->lock);
+	int need_unlock = __lockfile(f);
 	int r = putc_unlocked(c, f);
-	pthread_mutex_unlock(&f->lock);
+	if (need_unlock)
+		__unlockfile(f);
 	return r;
 }
 
@@ -1,13 +1,26 @@
 #include "stdio_impl.h"
+#include "libc.h"
+#include "libc-api.h"
 
+// A thread that already holds the lock of the FILE, e.g. in nested stdio
+// calls, does not lock again. The return value tells whether the caller has to
+// unlock.
 int __lockfile(FILE *f)
 {
-	pthread_mutex_lock(&f->lock);
+	if (!libc.need_locks)
+		return 0;
+
+	pthread_descr self = ptlc_thread_descr_self();
+	if (f->owner == self)
+		return 0;
 
-	return 1; // return 1, since we need unlock
+	pthread_mutex_lock(&f->lock);
+	f->owner = self;
+	return 1;
 }
 
 void __unlockfile(FILE *f)
 {
+	f->owner = 0;
 	pthread_mutex_unlock(&f->lock);
 }
@@ -10,7 +10,9 @@ void __lock(libc_lock_t *l)
 	int need_locks = libc.need_locks;
 	if (!need_locks) return;
 
-	__pthread_lock(l, __pthread_thread_self());
+	// The descriptor of the thread is only needed to wait for the lock, so
+	// let __pthread_lock() look it up then.
+	__pthread_lock(l, NULL);
 }
 
 void __unlock(libc_lock_t *l)
@@ -31,6 +31,7 @@ static void init_file_lock(FILE *f)
     {
       f->needs_lock = 0;
       f->lock = FILE_LOCK_INITIALIZER;
+      f->owner = 0;
     }
 }
 
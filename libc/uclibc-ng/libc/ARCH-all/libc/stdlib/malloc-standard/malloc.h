@@ -109,10 +109,10 @@ __UCLIBC_MUTEX_EXTERN(__malloc_lock)
 */
 #ifndef MORECORE_CONTIGUOUS
 /*
- * L4Re: The L4Re implementation does not provide necessarily
- * consecutive memory when using morecore
+ * L4Re: morecore moves a break through a reserved area. When the area is
+ * exhausted, morecore fails and malloc falls back to mmap.
  */
-#define MORECORE_CONTIGUOUS 0
+#define MORECORE_CONTIGUOUS 1
 #endif
 
 /*
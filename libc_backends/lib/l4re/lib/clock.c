@@ -1,6 +1,11 @@
 #include <time.h>
 
+#include "clocks.h"
+
 clock_t clock(void)
 {
-  return -1;
+  struct timespec ts;
+  __libc_l4_process_cputime(&ts);
+  return (clock_t)ts.tv_sec * CLOCKS_PER_SEC
+         + ts.tv_nsec / (1000000000 / CLOCKS_PER_SEC);
 }
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2026 Kernkonzept GmbH.
+ *
+ * License: see LICENSE.spdx (in this directory or the directories above)
+ */
+
+#include <time.h>
+#include <l4/re/env.h>
+#include <l4/sys/thread.h>
+#include <pthread.h>
+#include <pthread-l4.h>
+
+#include "clocks.h"
+
+/*
+ * Use the thread list of libpthread if the program is linked against it.
+ * Otherwise the main thread is the only thread.
+ */
+#pragma weak pthread_self
+#pragma weak pthread_l4_cap
+#pragma weak pthread_l4_for_each_thread
+#pragma weak pthread_mutex_lock
+#pragma weak pthread_mutex_unlock
+
+static void us_to_timespec(l4_kernel_clock_t us, struct timespec *tp)
+{
+  tp->tv_sec  = us / 1000000;
+  tp->tv_nsec = (us % 1000000) * 1000;
+}
+
+static l4_kernel_clock_t thread_time(l4_cap_idx_t thread)
+{
+  l4_kernel_clock_t us;
+  if (l4_error(l4_thread_stats_time(thread, &us)) < 0)
+    return 0;
+  return us;
+}
+
+static l4_cap_idx_t self_cap(void)
+{
+  if (pthread_l4_cap)
+    return pthread_l4_cap(pthread_self());
+
+  return l4re_env()->main_thread;
+}
+
+int __libc_l4_thread_cputime(struct timespec *tp)
+{
+  us_to_timespec(thread_time(self_cap()), tp);
+  return 0;
+}
+
+/*
+ * The callback of pthread_l4_for_each_thread() gets no context, so the
+ * sum is kept in a static variable protected by a mutex.
+ */
+static pthread_mutex_t sum_lock = PTHREAD_MUTEX_INITIALIZER;
+static l4_kernel_clock_t sum_us;
+
+static void add_thread_time(pthread_t t)
+{
+  sum_us += thread_time(pthread_l4_cap(t));
+}
+
+int __libc_l4_process_cputime(struct timespec *tp)
+{
+  l4_kernel_clock_t us;
+
+  if (pthread_l4_for_each_thread)
+    {
+      pthread_mutex_lock(&sum_lock);
+      sum_us = 0;
+      pthread_l4_for_each_thread(add_thread_time);
+      us = sum_us;
+      pthread_mutex_unlock(&sum_lock);
+    }
+  else
+    us = thread_time(l4re_env()->main_thread);
+
+  us_to_timespec(us, tp);
+  return 0;
+}
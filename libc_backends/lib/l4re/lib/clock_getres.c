@@ -10,8 +10,20 @@
 
 int clock_getres(clockid_t clock_id, struct timespec * res)
 {
-  if (clock_id != CLOCK_REALTIME && clock_id != CLOCK_MONOTONIC)
+  long nsec;
+
+  switch (clock_id)
     {
+    case CLOCK_REALTIME:
+    case CLOCK_MONOTONIC:
+      nsec = 1;
+      break;
+    case CLOCK_PROCESS_CPUTIME_ID:
+    case CLOCK_THREAD_CPUTIME_ID:
+      // The kernel accounts execution time in microseconds.
+      nsec = 1000;
+      break;
+    default:
       errno = EINVAL;
       return -1;
     }
@@ -19,7 +31,7 @@ int clock_getres(clockid_t clock_id, struct timespec * res)
   if (res)
     {
       res->tv_sec = 0;
-      res->tv_nsec = 1000;
+      res->tv_nsec = nsec;
     }
 
   return 0;
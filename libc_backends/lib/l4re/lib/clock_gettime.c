@@ -18,16 +18,22 @@
 typedef int Get_clock(struct timespec *);
 uint64_t __attribute__((weak)) __libc_l4_rt_clock_offset;
 
+/*
+ * Both clocks use the nanosecond reader of the KIP. This is kernel-provided
+ * code executed in user mode, it scales the architectural counter (e.g.,
+ * TSC or the generic timer) without entering the kernel. The real-time
+ * offset is kept in microseconds.
+ */
 int __attribute__((weak))
 libc_backend_rt_clock_gettime(struct timespec *tp)
 {
   uint64_t clock;
 
-  clock = l4_kip_clock(l4re_kip());
-  clock += __libc_l4_rt_clock_offset;
+  clock = l4_kip_clock_ns(l4re_kip());
+  clock += __libc_l4_rt_clock_offset * 1000;
 
-  tp->tv_sec  = clock / 1000000;
-  tp->tv_nsec = (clock % 1000000) * 1000;
+  tp->tv_sec  = clock / 1000000000;
+  tp->tv_nsec = clock % 1000000000;
 
   return 0;
 }
@@ -35,9 +41,9 @@ libc_backend_rt_clock_gettime(struct timespec *tp)
 static int mono_clock_gettime(struct timespec *tp)
 {
   uint64_t clock;
-  clock = l4_kip_clock(l4re_kip());
-  tp->tv_sec = clock / 1000000;
-  tp->tv_nsec = (clock % 1000000) * 1000;
+  clock = l4_kip_clock_ns(l4re_kip());
+  tp->tv_sec = clock / 1000000000;
+  tp->tv_nsec = clock % 1000000000;
 
   return 0;
 }
@@ -45,7 +51,9 @@ static int mono_clock_gettime(struct timespec *tp)
 Get_clock *__libc_l4_gettime[4] =
 {
   [CLOCK_REALTIME]  = libc_backend_rt_clock_gettime,
-  [CLOCK_MONOTONIC] = mono_clock_gettime
+  [CLOCK_MONOTONIC] = mono_clock_gettime,
+  [CLOCK_PROCESS_CPUTIME_ID] = __libc_l4_process_cputime,
+  [CLOCK_THREAD_CPUTIME_ID]  = __libc_l4_thread_cputime,
 };
 
 int clock_gettime(clockid_t clk_id, struct timespec *tp)
@@ -6,3 +6,9 @@
 #pragma once
 
 enum { NCLOCKS = 4 };
+
+struct timespec;
+
+/* CPU-time clocks, backed by the execution time accounted by the kernel. */
+int __libc_l4_thread_cputime(struct timespec *tp);
+int __libc_l4_process_cputime(struct timespec *tp);
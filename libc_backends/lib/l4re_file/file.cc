@@ -1273,6 +1273,36 @@ noexcept(noexcept(mkfifo(p, m)))
   return -1;
 }
 
+extern "C" int pipe2(int pipefd[2], int flags)
+noexcept(noexcept(pipe2(pipefd, flags)))
+{
+  int r = L4Re::Vfs::vfs_ops->pipe2(pipefd, flags);
+  ERRNO_RET(r);
+  return 0;
+}
+
+extern "C" int pipe(int pipefd[2])
+noexcept(noexcept(pipe(pipefd)))
+{
+  return pipe2(pipefd, 0);
+}
+
+extern "C" int shm_open(const char *name, int oflag, mode_t mode)
+noexcept(noexcept(shm_open(name, oflag, mode)))
+{
+  int r = L4Re::Vfs::vfs_ops->shm_open(name, oflag, mode);
+  ERRNO_RET(r);
+  return r;
+}
+
+extern "C" int shm_unlink(const char *name)
+noexcept(noexcept(shm_unlink(name)))
+{
+  int r = L4Re::Vfs::vfs_ops->shm_unlink(name);
+  ERRNO_RET(r);
+  return 0;
+}
+
 extern "C" int memfd_create(const char *name, unsigned int flags)
 noexcept(noexcept(memfd_create(name, flags)))
 {
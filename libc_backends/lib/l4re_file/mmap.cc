@@ -10,9 +10,12 @@
 #include <l4/re/dataspace>
 #include <l4/re/env>
 #include <l4/re/util/cap_alloc>
+#include <l4/re/mem_alloc>
+#include <l4/cxx/minmax>
 #include <sys/mman.h>
 #include <unistd.h>
 #include <stdio.h>
+#include <string.h>
 #include <errno.h>
 #include <l4/l4re_vfs/backend>
 #include <bits/l4-malloc.h>
@@ -25,12 +28,72 @@
     POST();                  \
   }
 
+/*
+ * Memory locking.
+ *
+ * Locking maps the range eagerly, so that accessing it does not fault. The
+ * pages are not pinned, there is no pin count in the dataspace managers, so
+ * locked pages can still lose their mapping: unmapping the region,
+ * Dataspace::clear() and madvise() take them away. Moe also write-protects
+ * the pages of a dataspace whenever they become shared copy-on-write, i.e.,
+ * when the dataspace is the source of Dataspace::copy_in() or is cloned.
+ * The next write to such a locked page faults and gets a private copy.
+ *
+ * As locking keeps no state, munlock() only checks its arguments.
+ */
+
+/* Set by mlockall(MCL_FUTURE) without MCL_ONFAULT. */
+static bool mlock_future;
+
+/*
+ * Map the pages of [start, end) with the rights of their regions, so that
+ * accessing them does not fault, unless `page_in` is false. The whole range
+ * must be covered by regions.
+ */
+static int lock_range(l4_addr_t start, l4_addr_t end, bool page_in = true)
+{
+  using L4Re::Rm;
+  L4::Cap<Rm> rm = L4Re::Env::env()->rm();
+
+  while (start < end)
+    {
+      l4_addr_t a = start;
+      unsigned long sz = 1;
+      Rm::Offset offs;
+      Rm::Flags flags;
+      L4::Cap<L4Re::Dataspace> ds;
+      if (rm->find(&a, &sz, &offs, &flags, &ds) < 0
+          || (flags.attach_flags() & Rm::F::In_area))
+        return -ENOMEM;
+
+      l4_addr_t e = cxx::min<l4_addr_t>(end, a + sz);
+      Rm::Region_flags rf = flags.region_flags();
+
+      // Inaccessible pages cannot be mapped, like on Linux they are only
+      // locked once they become accessible.
+      if (page_in
+          && (rf & Rm::F::R) && !(rf & (Rm::F::Reserved | Rm::F::Kernel)))
+        {
+          long err = rm->page_in(start, e - start, rf & Rm::F::RWX);
+          if (err < 0)
+            return err == -L4_ENOMEM ? -ENOMEM : -EAGAIN;
+        }
+
+      start = e;
+    }
+
+  return 0;
+}
+
 extern "C" void *mmap2(void *addr, size_t length, int prot, int flags,
                        int fd, off_t pgoffset) noexcept;
 void *mmap2(void *addr, size_t length, int prot, int flags,
             int fd, off_t pgoffset) noexcept
 {
   void *resptr;
+  if (mlock_future)
+    flags |= MAP_LOCKED;
+
   int r = L4B(mmap2(addr, length, prot, flags, fd, pgoffset, &resptr));
   if (r < 0)
     {
@@ -65,41 +128,164 @@ L4B_REDIRECT_3(int, msync, void *, size_t, int);
 
 /* Use mmap from VFS unless the heap is provided by libc_be_static_heap. */
 #ifndef CONFIG_BID_STATIC_HEAP
-static void *current_morecore_end;
+/*
+ * The heap lives in a virtual area reserved on first use. The break moves
+ * through the area like brk(), so malloc can grow its top chunk in place
+ * and give memory back. One anonymous dataspace backs the whole area. It is
+ * attached in chunks of growing size as the break advances, and the pages
+ * above a shrinking break are returned with Dataspace::clear().
+ *
+ * Called with the malloc lock held.
+ */
+enum : unsigned long
+{
+  Heap_area_size  = sizeof(long) == 8 ? 1UL << 30 : 64UL << 20,
+  Heap_min_attach = 1UL << 20,
+};
+
+static char *heap_start;
+static char *heap_brk;
+static char *heap_attached; // end of the attached part of the area
+static l4_cap_idx_t heap_ds = L4_INVALID_CAP;
+static bool heap_failed;
+
+static bool heap_init()
+{
+  using L4Re::Rm;
+  L4Re::Env const *e = L4Re::Env::env();
+
+  auto ds = L4Re::Util::cap_alloc.alloc<L4Re::Dataspace>();
+  if (!ds.is_valid())
+    return false;
+
+  // Pages are only allocated when touched.
+  if (e->mem_alloc()->alloc(Heap_area_size, ds) < 0)
+    {
+      L4Re::Util::cap_alloc.free(ds);
+      return false;
+    }
+
+  l4_addr_t a = L4_PAGESIZE;
+  if (e->rm()->reserve_area(&a, Heap_area_size, Rm::F::Search_addr,
+                            L4_SUPERPAGESHIFT) < 0)
+    {
+      L4Re::Util::cap_alloc.free(ds);
+      return false;
+    }
+
+  heap_ds = ds.cap();
+  heap_start = heap_brk = heap_attached = reinterpret_cast<char *>(a);
+  return true;
+}
+
+/* Attach the dataspace up to at least `end`. */
+static bool heap_attach(char *end)
+{
+  using L4Re::Rm;
+
+  unsigned long attached = heap_attached - heap_start;
+  unsigned long sz = end - heap_attached;
+
+  // Double the attached part each time to keep the number of regions low.
+  sz = cxx::max<unsigned long>(sz, attached, Heap_min_attach);
+  sz = cxx::min<unsigned long>(l4_round_size(sz, L4_SUPERPAGESHIFT),
+                               Heap_area_size - attached);
+
+  char *a = heap_attached;
+  L4::Cap<L4Re::Dataspace> ds(heap_ds);
+  if (L4Re::Env::env()->rm()->attach(&a, sz, Rm::F::In_area | Rm::F::RW,
+                                     L4::Ipc::make_cap_rw(ds), attached,
+                                     L4_SUPERPAGESHIFT) < 0)
+    return false;
+
+  heap_attached += sz;
+  return true;
+}
 
 void *uclibc_morecore(long bytes)
 {
-  // calling morecore with 0 size is done by the malloc implementation
-  // to check for the amount of memory it got from the last call to morecore
-  // With a negative value, 'free' wants to return memory, we do not support
-  // that here.
-  if (bytes <= 0)
-    return current_morecore_end;
-
-  size_t s = l4_round_page(bytes);
-  void *b = mmap2(0, s, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, 0, 0);
-  if (L4_UNLIKELY(b == MAP_FAILED))
-    return b;
-
-  current_morecore_end = static_cast<char *>(b) + s;
-  return b;
+  if (L4_UNLIKELY(!heap_start))
+    {
+      if (heap_failed || !heap_init())
+        {
+          // Let malloc fall back to mmap.
+          heap_failed = true;
+          errno = ENOMEM;
+          return MAP_FAILED;
+        }
+    }
+
+  char *old_brk = heap_brk;
+
+  if (bytes > 0)
+    {
+      if (static_cast<unsigned long>(bytes)
+          > Heap_area_size - (heap_brk - heap_start))
+        {
+          errno = ENOMEM;
+          return MAP_FAILED;
+        }
+
+      char *new_brk = heap_brk + bytes;
+      if (new_brk > heap_attached && !heap_attach(new_brk))
+        {
+          errno = ENOMEM;
+          return MAP_FAILED;
+        }
+
+      if (mlock_future)
+        lock_range(l4_trunc_page(reinterpret_cast<l4_addr_t>(old_brk)),
+                      l4_round_page(reinterpret_cast<l4_addr_t>(new_brk)));
+
+      heap_brk = new_brk;
+    }
+  else if (bytes < 0)
+    {
+      char *new_brk = heap_brk + cxx::max<long>(bytes, heap_start - heap_brk);
+      unsigned long from = l4_round_page(new_brk - heap_start);
+      unsigned long to = l4_round_page(heap_brk - heap_start);
+
+      // Give the pages above the new break back to the memory allocator.
+      if (from < to)
+        {
+          L4::Cap<L4Re::Dataspace> ds(heap_ds);
+          ds->clear(from, to - from);
+        }
+
+      heap_brk = new_brk;
+    }
+
+  return old_brk;
 }
 #endif
 
-int mlock2([[maybe_unused]] const void *__addr, [[maybe_unused]] size_t len,
-           [[maybe_unused]] unsigned int flags)
+int mlock2(const void *__addr, size_t len, unsigned int flags)
 noexcept(noexcept(mlock2(__addr, len, flags)))
 {
-  /* Implementation:
-   * - Search for all regions between __addr and __addr+len
-   *   - for each region:
-   *     - page it in if flags != MLOCK_ONFAULT
-   *     - tag range in dataspace that it is locked now
-   *       - for that, add API to dataspace to lock+unlock pages
-   *         (consider that dataspaces can be used from multiple tasks and
-   *         that locking is a individual task-decision that needs to be
-   *         considered for munlock, use a counter per page?)
-   */
+  if (flags & ~MLOCK_ONFAULT)
+    {
+      errno = EINVAL;
+      return -1;
+    }
+
+  l4_addr_t start = l4_trunc_page(reinterpret_cast<l4_addr_t>(__addr));
+  l4_addr_t end = l4_round_page(reinterpret_cast<l4_addr_t>(__addr) + len);
+  if (end < start)
+    {
+      errno = ENOMEM;
+      return -1;
+    }
+
+  // Pages locked on fault need nothing: mapped pages stay resident.
+  if (flags & MLOCK_ONFAULT)
+    return 0;
+
+  int err = lock_range(start, end);
+  if (err < 0)
+    {
+      errno = -err;
+      return -1;
+    }
 
   return 0;
 }
@@ -110,32 +296,87 @@ noexcept(noexcept(mlock(__addr, __len)))
   return mlock2(__addr, __len, 0);
 }
 
-int munlock([[maybe_unused]] const void *addr, [[maybe_unused]] size_t len)
+int munlock(const void *addr, size_t len)
 noexcept(noexcept(munlock(addr, len)))
 {
-  /* Implementation:
-   * - Search for all regions between __addr and __addr+len
-   *   - for each region:
-   *     - unlock range in dataspace
-   *       - for that, add API to dataspace to lock+unlock pages
-   */
+  l4_addr_t start = l4_trunc_page(reinterpret_cast<l4_addr_t>(addr));
+  l4_addr_t end = l4_round_page(reinterpret_cast<l4_addr_t>(addr) + len);
+  int err = end < start ? -ENOMEM : lock_range(start, end, false);
+  if (err < 0)
+    {
+      errno = -err;
+      return -1;
+    }
+
   return 0;
 }
 
-int mlockall([[maybe_unused]] int flags)
+/* Map all regions of the task that can be accessed. */
+static int page_in_all()
+{
+  using L4Re::Rm;
+
+  enum
+  {
+    Max_num_regions = L4_UTCB_GENERIC_DATA_SIZE * sizeof(l4_umword_t)
+                      / sizeof(Rm::Region),
+  };
+
+  Rm::Region regions[Max_num_regions];
+  Rm::Region const *rl;
+  L4::Cap<Rm> rm = L4Re::Env::env()->rm();
+  l4_addr_t addr = 0;
+  long n;
+
+  while ((n = rm->get_regions(addr, &rl)) > 0)
+    {
+      // Copy out of the UTCB, paging in uses it.
+      n = cxx::min<long>(n, Max_num_regions);
+      memcpy(regions, rl, n * sizeof(Rm::Region));
+
+      for (long i = 0; i < n; ++i)
+        {
+          Rm::Region const &r = regions[i];
+          if (!(r.flags & Rm::F::R)
+              || (r.flags & (Rm::F::Reserved | Rm::F::Kernel)))
+            continue;
+
+          // Regions without memory of their own are skipped.
+          if (rm->page_in(r.start, r.end - r.start + 1,
+                          r.flags & Rm::F::RWX) == -L4_ENOMEM)
+            return -ENOMEM;
+        }
+
+      if (regions[n - 1].end == ~0UL)
+        break;
+      addr = regions[n - 1].end + 1;
+    }
+
+  return n < 0 ? -EAGAIN : 0;
+}
+
+int mlockall(int flags)
 noexcept(noexcept(mlockall(flags)))
 {
-  /* Implementation:
-   * - Search for all regions
-   *   - For reach region
-   *     if flags | MCL_CURRENT:
-   *       go to dataspace and lock range
-   *     if flags | MCL_FUTURE:
-   *       go to rm and tell it to map all future pages with lock-flag
-   *       (API extension here!)
-   *     if flags | MCL_ONFAULT:
-   *       see manpage...
-   */
+  if (!(flags & (MCL_CURRENT | MCL_FUTURE))
+      || (flags & ~(MCL_CURRENT | MCL_FUTURE | MCL_ONFAULT)))
+    {
+      errno = EINVAL;
+      return -1;
+    }
+
+  // Future mappings are attached with Rm::F::Eager_map.
+  mlock_future = (flags & (MCL_FUTURE | MCL_ONFAULT)) == MCL_FUTURE;
+
+  if ((flags & (MCL_CURRENT | MCL_ONFAULT)) == MCL_CURRENT)
+    {
+      int err = page_in_all();
+      if (err < 0)
+        {
+          errno = -err;
+          return -1;
+        }
+    }
 
   return 0;
 }
@@ -143,12 +384,7 @@ noexcept(noexcept(mlockall(flags)))
 int munlockall(void)
 noexcept(noexcept(munlockall()))
 {
-  /* Implementation:
-   * - Search for all regions
-   *   - For each region
-   *     go to dataspace and unlock range
-   *     go to rm to remove unlock flag for mappings
-   */
+  mlock_future = false;
   return 0;
 }
 
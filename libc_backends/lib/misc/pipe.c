@@ -6,17 +6,6 @@
  */
 
 #include <stdio.h>
-#include <errno.h>
-#include <unistd.h>
-
-int pipe(int pipefd[2])
-{
-  printf("Unimplemented: %s()\n", __func__);
-  printf("    Caller %p\n", __builtin_return_address(0));
-  (void)pipefd;
-  errno = EINVAL;
-  return -1;
-}
 
 FILE *popen(const char *command, const char *type)
 {
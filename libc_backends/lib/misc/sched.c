@@ -6,8 +6,22 @@
 
 #include <sched.h>
 #include <errno.h>
+#include <pthread.h>
+#include <string.h>
 #include <unistd.h>
 
+#include <l4/re/consts.h>
+#include <l4/re/env.h>
+#include <l4/sys/scheduler.h>
+
+/*
+ * Use the thread-aware implementations of libpthread if the program is
+ * linked against it. Otherwise the main thread is the only thread.
+ */
+#pragma weak pthread_self
+#pragma weak pthread_getaffinity_np
+#pragma weak pthread_setaffinity_np
+
 int sched_get_priority_max(int policy)
 {
   (void)policy;
@@ -20,17 +34,110 @@ int sched_get_priority_min(int policy)
   return 1;
 }
 
-int sched_getcpu(void)
+static int is_self(pid_t pid)
 {
-  // In a general sense we don't know, so just report the first CPU
-  return 0;
+  return pid == 0 || pid == getpid();
 }
 
 int sched_getaffinity(pid_t pid, size_t cpusetsize,
                       cpu_set_t *mask)
 {
-  (void)pid;
-  CPU_SET_S(1, cpusetsize, mask);
+  enum { Word_bits = sizeof(l4_umword_t) * 8 };
+
+  if (!is_self(pid))
+    {
+      errno = ESRCH;
+      return -1;
+    }
+
+  if (cpusetsize < sizeof(l4_umword_t))
+    {
+      errno = EINVAL;
+      return -1;
+    }
+
+  if (pthread_getaffinity_np)
+    {
+      int err = pthread_getaffinity_np(pthread_self(), cpusetsize, mask);
+      if (err)
+        {
+          errno = err;
+          return -1;
+        }
+      return 0;
+    }
+
+  memset(mask, 0, cpusetsize);
+  l4_umword_t *words = (l4_umword_t *)mask;
+  for (size_t i = 0; i < cpusetsize / sizeof(l4_umword_t); ++i)
+    {
+      l4_sched_cpu_set_t cs = l4_sched_cpu_set(i * Word_bits, 0, 0);
+      if (l4_error(l4_scheduler_info(l4re_env()->scheduler, NULL, &cs)) < 0)
+        break;
+
+      words[i] = cs.map;
+    }
+
+  if (!CPU_COUNT_S(cpusetsize, mask))
+    CPU_SET_S(0, cpusetsize, mask);
+
+  return 0;
+}
+
+int sched_setaffinity(pid_t pid, size_t cpusetsize,
+                      const cpu_set_t *mask)
+{
+  if (!is_self(pid))
+    {
+      errno = ESRCH;
+      return -1;
+    }
+
+  if (pthread_setaffinity_np)
+    {
+      int err = pthread_setaffinity_np(pthread_self(), cpusetsize, mask);
+      if (err)
+        {
+          errno = err;
+          return -1;
+        }
+      return 0;
+    }
+
+  // The scheduler takes one word of CPUs.
+  l4_umword_t const *words = (l4_umword_t const *)mask;
+  if (cpusetsize < sizeof(l4_umword_t) || !words[0]
+      || CPU_COUNT_S(cpusetsize, mask) != __builtin_popcountl(words[0]))
+    {
+      errno = EINVAL;
+      return -1;
+    }
+
+  l4_sched_param_t sp = l4_sched_param(L4RE_MAIN_THREAD_PRIO, 0);
+  sp.affinity = l4_sched_cpu_set(0, 0, words[0]);
+  long err = l4_error(l4_scheduler_run_thread(l4re_env()->scheduler,
+                                              l4re_env()->main_thread, &sp));
+  if (err < 0)
+    {
+      errno = -err;
+      return -1;
+    }
+
+  return 0;
+}
+
+int sched_getcpu(void)
+{
+  // The kernel does not tell us where we currently run. Report the first CPU
+  // the calling thread may run on, which is exact for pinned threads.
+  cpu_set_t set;
+  if (sched_getaffinity(0, sizeof(set), &set) < 0)
+    return 0;
+
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+    if (CPU_ISSET(cpu, &set))
+      return cpu;
+
   return 0;
 }
 
@@ -5,34 +5,376 @@
  * License: see LICENSE.spdx (in this directory or the directories above)
  */
 
-#include <stdio.h>
+/*
+ * System V shared memory on top of the POSIX shared memory objects of the
+ * L4Re VFS.
+ *
+ * The segment of a key is the object "sysv.<key>", so tasks sharing the
+ * name space of the objects share the segments. IPC_PRIVATE segments are
+ * unlinked right after creation. Each segment keeps a file descriptor of
+ * the object open until the segment is removed and detached. The shmid is
+ * a separate number, so close() on a shmid does not affect the segment.
+ * The descriptor itself is an ordinary one, though: closing it behind the
+ * back of this module, e.g. by closing all descriptors of the task, makes
+ * later shmat() calls fail.
+ * The numbers of attachments are local to the task.
+ */
+
 #include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
 #include <sys/shm.h>
+#include <sys/stat.h>
+#include <l4/sys/consts.h>
 
-int shmget(key_t key, size_t size, int shmflg)
+/*
+ * The POSIX objects are provided by the L4Re file backend, and the lock is
+ * only needed if the program is linked against libpthread.
+ */
+#pragma weak shm_open
+#pragma weak shm_unlink
+#pragma weak pthread_mutex_lock
+#pragma weak pthread_mutex_unlock
+
+struct shm_seg
 {
-  printf("%s(%d, %zd, %d)\n", __func__, key, size, shmflg);
-  errno = ENOSYS;
-  return -1;
+  struct shm_seg *next;
+  int id;
+  int fd;
+  key_t key;
+  size_t size;
+  mode_t mode;
+  unsigned long nattch;
+  int removed;
+  char name[32];
+};
+
+struct shm_att
+{
+  struct shm_att *next;
+  void *addr;
+  struct shm_seg *seg;
+};
+
+static pthread_mutex_t shm_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct shm_seg *segs;
+static struct shm_att *atts;
+static int last_id;
+
+static void lock(void)
+{
+  if (pthread_mutex_lock)
+    pthread_mutex_lock(&shm_lock);
 }
 
-void *shmat(int shmid, const void *shmaddr, int shmflg)
+static void unlock(void)
 {
-  printf("%s(%d, %p, %d)\n", __func__, shmid, shmaddr, shmflg);
-  errno = ENOSYS;
-  return (void *)-1;
+  if (pthread_mutex_unlock)
+    pthread_mutex_unlock(&shm_lock);
 }
 
-int shmctl(int shmid, int cmd, struct shmid_ds *buf)
+static struct shm_seg *find_id(int id)
 {
-  printf("%s(%d, %d, %p)\n", __func__, shmid, cmd, buf);
-  errno = ENOSYS;
+  struct shm_seg *s;
+  for (s = segs; s; s = s->next)
+    if (s->id == id)
+      return s;
+  return NULL;
+}
+
+static struct shm_seg *find_key(key_t key)
+{
+  struct shm_seg *s;
+  for (s = segs; s; s = s->next)
+    if (s->key == key && !s->removed)
+      return s;
+  return NULL;
+}
+
+static void drop_seg(struct shm_seg *seg)
+{
+  struct shm_seg **p;
+  for (p = &segs; *p != seg; p = &(*p)->next)
+    ;
+  *p = seg->next;
+  close(seg->fd);
+  free(seg);
+}
+
+/* Open or create the object of a segment, return its file descriptor. */
+static int open_object(struct shm_seg *seg, size_t size, int shmflg)
+{
+  static unsigned private_cnt;
+  int oflag = O_RDWR;
+  int fd;
+
+  if (seg->key == IPC_PRIVATE)
+    {
+      /* Find an unused name, the name space may be shared. */
+      do
+        {
+          snprintf(seg->name, sizeof(seg->name), "sysv.private.%lx.%x",
+                   (unsigned long)seg, private_cnt++);
+          fd = shm_open(seg->name, O_RDWR | O_CREAT | O_EXCL,
+                        shmflg & 0777);
+        }
+      while (fd < 0 && errno == EEXIST);
+    }
+  else
+    {
+      snprintf(seg->name, sizeof(seg->name), "sysv.%x", (unsigned)seg->key);
+      if (shmflg & IPC_CREAT)
+        oflag |= O_CREAT;
+      if (shmflg & IPC_EXCL)
+        oflag |= O_EXCL;
+      fd = shm_open(seg->name, oflag, shmflg & 0777);
+    }
+
+  if (fd < 0)
+    return -1;
+
+  struct stat st;
+  if (fstat(fd, &st) < 0)
+    goto fail;
+
+  if (st.st_size == 0)
+    {
+      /* We created the object. */
+      if (size == 0)
+        {
+          errno = EINVAL;
+          goto fail_unlink;
+        }
+
+      if (ftruncate(fd, size) < 0)
+        {
+          if (errno == EFBIG)
+            errno = EINVAL;
+          goto fail_unlink;
+        }
+
+      if (fstat(fd, &st) < 0)
+        goto fail_unlink;
+    }
+  else if (size > (size_t)st.st_size)
+    {
+      errno = EINVAL;
+      goto fail;
+    }
+
+  seg->size = st.st_size;
+
+  /* Our descriptor keeps a private object alive. */
+  if (seg->key == IPC_PRIVATE)
+    shm_unlink(seg->name);
+
+  return fd;
+
+fail_unlink:
+  if (seg->key == IPC_PRIVATE)
+    shm_unlink(seg->name);
+fail:
+  close(fd);
   return -1;
 }
 
+int shmget(key_t key, size_t size, int shmflg)
+{
+  struct shm_seg *seg;
+  int id;
+
+  if (!shm_open)
+    {
+      errno = ENOSYS;
+      return -1;
+    }
+
+  lock();
+  if (key != IPC_PRIVATE && (seg = find_key(key)))
+    {
+      id = seg->id;
+      if ((shmflg & IPC_CREAT) && (shmflg & IPC_EXCL))
+        {
+          errno = EEXIST;
+          id = -1;
+        }
+      else if (size > seg->size)
+        {
+          errno = EINVAL;
+          id = -1;
+        }
+      unlock();
+      return id;
+    }
+
+  seg = calloc(1, sizeof(*seg));
+  if (!seg)
+    {
+      unlock();
+      errno = ENOMEM;
+      return -1;
+    }
+
+  seg->key = key;
+  seg->mode = shmflg & 0777;
+  seg->fd = open_object(seg, size, shmflg);
+  if (seg->fd < 0)
+    {
+      unlock();
+      free(seg);
+      return -1;
+    }
+
+  /* Skip ids still in use after a wrap-around. */
+  do
+    last_id = last_id == INT_MAX ? 1 : last_id + 1;
+  while (find_id(last_id));
+
+  id = seg->id = last_id;
+  seg->next = segs;
+  segs = seg;
+  unlock();
+  return id;
+}
+
+void *shmat(int shmid, const void *shmaddr, int shmflg)
+{
+  struct shm_seg *seg;
+  struct shm_att *att;
+  void *addr = (void *)shmaddr;
+  int prot = PROT_READ;
+  int flags = MAP_SHARED;
+
+  if (addr)
+    {
+      if (shmflg & SHM_RND)
+        addr = (void *)((unsigned long)addr & ~(L4_PAGESIZE - 1));
+      else if ((unsigned long)addr & (L4_PAGESIZE - 1))
+        {
+          errno = EINVAL;
+          return (void *)-1;
+        }
+      flags |= MAP_FIXED;
+    }
+
+  if (!(shmflg & SHM_RDONLY))
+    prot |= PROT_WRITE;
+
+  att = malloc(sizeof(*att));
+  if (!att)
+    {
+      errno = ENOMEM;
+      return (void *)-1;
+    }
+
+  lock();
+  seg = find_id(shmid);
+  if (!seg)
+    {
+      unlock();
+      free(att);
+      errno = EINVAL;
+      return (void *)-1;
+    }
+
+  addr = mmap(addr, seg->size, prot, flags, seg->fd, 0);
+  if (addr == MAP_FAILED)
+    {
+      unlock();
+      free(att);
+      return (void *)-1;
+    }
+
+  att->addr = addr;
+  att->seg = seg;
+  att->next = atts;
+  atts = att;
+  ++seg->nattch;
+  unlock();
+  return addr;
+}
+
 int shmdt(const void *shmaddr)
 {
-  printf("%s(%p)\n", __func__, shmaddr);
-  errno = ENOSYS;
-  return -1;
+  struct shm_att **p, *att;
+  struct shm_seg *seg;
+
+  lock();
+  for (p = &atts; *p && (*p)->addr != shmaddr; p = &(*p)->next)
+    ;
+
+  att = *p;
+  if (!att)
+    {
+      unlock();
+      errno = EINVAL;
+      return -1;
+    }
+
+  *p = att->next;
+  seg = att->seg;
+  munmap(att->addr, seg->size);
+  free(att);
+
+  if (!--seg->nattch && seg->removed)
+    drop_seg(seg);
+  unlock();
+  return 0;
+}
+
+int shmctl(int shmid, int cmd, struct shmid_ds *buf)
+{
+  struct shm_seg *seg;
+  int ret = 0;
+
+  lock();
+  seg = find_id(shmid);
+  if (!seg)
+    {
+      unlock();
+      errno = EINVAL;
+      return -1;
+    }
+
+  switch (cmd)
+    {
+    case IPC_STAT:
+      memset(buf, 0, sizeof(*buf));
+      buf->shm_perm.uid = buf->shm_perm.cuid = getuid();
+      buf->shm_perm.gid = buf->shm_perm.cgid = getgid();
+      buf->shm_perm.mode = seg->mode;
+      buf->shm_segsz = seg->size;
+      buf->shm_nattch = seg->nattch;
+      break;
+
+    case IPC_SET:
+      seg->mode = buf->shm_perm.mode & 0777;
+      break;
+
+    case IPC_RMID:
+      if (seg->removed)
+        break;
+
+      if (seg->key != IPC_PRIVATE)
+        shm_unlink(seg->name);
+
+      seg->removed = 1;
+      if (!seg->nattch)
+        drop_seg(seg);
+      break;
+
+    default:
+      errno = EINVAL;
+      ret = -1;
+      break;
+    }
+
+  unlock();
+  return ret;
 }
@@ -12,12 +12,41 @@
 #include <unistd.h>
 
 #include <l4/sys/consts.h>
+#include <l4/sys/scheduler.h>
+#include <l4/re/env.h>
 
 int __sched_cpucount(size_t __setsize, const cpu_set_t *__setp)
 {
-  (void)__setsize;
-  (void)__setp;
-  return 4; // just some number
+  unsigned char const *p = (unsigned char const *)__setp;
+  int cnt = 0;
+  for (size_t i = 0; i < __setsize; ++i)
+    cnt += __builtin_popcount(p[i]);
+  return cnt;
+}
+
+/*
+ * Count the online CPUs of our scheduler. Returns at least one, also if the
+ * scheduler cannot be queried.
+ */
+static long online_cpus(l4_umword_t *cpu_max)
+{
+  enum { Word_bits = sizeof(l4_umword_t) * 8 };
+  long cnt = 0;
+
+  *cpu_max = 1;
+  for (l4_umword_t offs = 0; offs < *cpu_max; offs += Word_bits)
+    {
+      l4_sched_cpu_set_t cs = l4_sched_cpu_set(offs, 0, 0);
+      if (l4_error(l4_scheduler_info(l4re_env()->scheduler, cpu_max, &cs)) < 0)
+        break;
+
+      cnt += __builtin_popcountl(cs.map);
+    }
+
+  if (*cpu_max < 1)
+    *cpu_max = 1;
+
+  return cnt ? cnt : 1;
 }
 
 long sysconf(int name)
@@ -25,7 +54,16 @@ long sysconf(int name)
   switch (name)
   {
   case _SC_NPROCESSORS_ONLN:
-    return __sched_cpucount(0, NULL);
+    {
+      l4_umword_t max;
+      return online_cpus(&max);
+    }
+  case _SC_NPROCESSORS_CONF:
+    {
+      l4_umword_t max;
+      online_cpus(&max);
+      return max;
+    }
   case _SC_PAGE_SIZE:
     return L4_PAGESIZE;
   case _SC_CLK_TCK:
@@ -5,15 +5,32 @@
  * License: see LICENSE.spdx (in this directory or the directories above)
  */
 
-#include <l4/re/env.h>
 #include <sys/times.h>
+#include <time.h>
+#include <unistd.h>
+
+static clock_t to_ticks(struct timespec const *ts)
+{
+  long hz = sysconf(_SC_CLK_TCK);
+  return (clock_t)ts->tv_sec * hz + ts->tv_nsec / (1000000000 / hz);
+}
 
 clock_t times(struct tms *buf)
 {
-  // some arbitrary values
-  buf->tms_utime = (clock_t)l4_kip_clock(l4re_kip());
-  buf->tms_stime = 10;
+  struct timespec ts;
+
+  // The kernel does not distinguish user and system time, account all
+  // execution time as user time. There are no child processes to report.
+  if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) < 0)
+    return (clock_t)-1;
+
+  buf->tms_utime = to_ticks(&ts);
+  buf->tms_stime = 0;
   buf->tms_cutime = 0;
   buf->tms_cstime = 0;
-  return (clock_t)l4_kip_clock(l4re_kip());
+
+  if (clock_gettime(CLOCK_MONOTONIC, &ts) < 0)
+    return (clock_t)-1;
+
+  return to_ticks(&ts);
 }
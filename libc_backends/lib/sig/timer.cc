@@ -0,0 +1,441 @@
+/*
+ * Copyright (C) 2026 Kernkonzept GmbH.
+ *
+ * License: see LICENSE.spdx (in this directory or the directories above)
+ */
+/**
+ * \file
+ * POSIX per-process timers.
+ *
+ * All timers of the process are served by a single thread that is started
+ * by the first timer_create(). Armed timers are kept in a binary min-heap
+ * ordered by their expiration time. The service thread blocks on a kernel
+ * semaphore with an absolute timeout for the earliest expiration. Arming a
+ * timer that becomes the earliest one wakes up the service thread.
+ *
+ * Expiration times are absolute KIP clock values in microseconds.
+ */
+
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <l4/re/env>
+#include <l4/re/itas>
+#include <l4/re/util/cap_alloc>
+#include <l4/sys/semaphore>
+#include <l4/libc_backends/clk.h>
+
+namespace {
+
+struct Posix_timer
+{
+  clockid_t clock;
+  struct sigevent ev;
+  /// Absolute time of the next expiration, 0 if the timer is disarmed.
+  l4_kernel_clock_t expiry;
+  /// Period of a periodic timer, 0 for a single-shot timer.
+  l4_kernel_clock_t interval;
+  /// Expirations merged into the last notification.
+  int overrun;
+  /// Index in the heap while the timer is armed.
+  unsigned pos;
+};
+
+struct Notify_args
+{
+  void (*fn)(union sigval);
+  union sigval value;
+};
+
+pthread_mutex_t timer_lock = PTHREAD_MUTEX_INITIALIZER;
+L4::Cap<L4::Semaphore> wakeup;
+Posix_timer **heap;
+unsigned heap_num, heap_size;
+
+l4_kernel_clock_t now()
+{ return l4_kip_clock(l4re_kip()); }
+
+l4_kernel_clock_t to_us(struct timespec const &ts)
+{ return ts.tv_sec * 1000000ULL + (ts.tv_nsec + 999) / 1000; }
+
+void to_timespec(l4_kernel_clock_t us, struct timespec *ts)
+{
+  ts->tv_sec = us / 1000000;
+  ts->tv_nsec = (us % 1000000) * 1000;
+}
+
+bool valid(struct timespec const &ts)
+{ return ts.tv_sec >= 0 && ts.tv_nsec >= 0 && ts.tv_nsec < 1000000000; }
+
+void heap_set(unsigned pos, Posix_timer *t)
+{
+  heap[pos] = t;
+  t->pos = pos;
+}
+
+void sift_up(unsigned pos)
+{
+  Posix_timer *t = heap[pos];
+  while (pos > 0)
+    {
+      unsigned parent = (pos - 1) / 2;
+      if (heap[parent]->expiry <= t->expiry)
+        break;
+      heap_set(pos, heap[parent]);
+      pos = parent;
+    }
+  heap_set(pos, t);
+}
+
+void sift_down(unsigned pos)
+{
+  Posix_timer *t = heap[pos];
+  for (;;)
+    {
+      unsigned child = 2 * pos + 1;
+      if (child >= heap_num)
+        break;
+      if (child + 1 < heap_num && heap[child + 1]->expiry < heap[child]->expiry)
+        ++child;
+      if (t->expiry <= heap[child]->expiry)
+        break;
+      heap_set(pos, heap[child]);
+      pos = child;
+    }
+  heap_set(pos, t);
+}
+
+bool heap_insert(Posix_timer *t)
+{
+  if (heap_num == heap_size)
+    {
+      unsigned n = heap_size ? heap_size * 2 : 16;
+      void *h = realloc(heap, n * sizeof(heap[0]));
+      if (!h)
+        return false;
+      heap = static_cast<Posix_timer **>(h);
+      heap_size = n;
+    }
+
+  heap_set(heap_num++, t);
+  sift_up(t->pos);
+  return true;
+}
+
+void heap_remove(Posix_timer *t)
+{
+  unsigned pos = t->pos;
+  Posix_timer *last = heap[--heap_num];
+  t->expiry = 0;
+  if (last == t)
+    return;
+
+  heap_set(pos, last);
+  if (pos > 0 && heap[(pos - 1) / 2]->expiry > last->expiry)
+    sift_up(pos);
+  else
+    sift_down(pos);
+}
+
+void *notify_thread(void *arg)
+{
+  Notify_args a = *static_cast<Notify_args *>(arg);
+  free(arg);
+  a.fn(a.value);
+  return nullptr;
+}
+
+void notify(struct sigevent const &ev)
+{
+  switch (ev.sigev_notify)
+    {
+    case SIGEV_SIGNAL:
+      L4Re::Env::env()->itas()->kill(ev.sigev_signo);
+      break;
+
+    case SIGEV_THREAD:
+      {
+        auto *a = static_cast<Notify_args *>(malloc(sizeof(Notify_args)));
+        if (!a)
+          break;
+
+        a->fn = ev.sigev_notify_function;
+        a->value = ev.sigev_value;
+
+        pthread_t th;
+        if (pthread_create(&th, ev.sigev_notify_attributes, notify_thread, a))
+          free(a);
+        else
+          pthread_detach(th);
+      }
+      break;
+
+    default:
+      break;
+    }
+}
+
+void *service_thread(void *)
+{
+  // Signals shall be handled by the application threads.
+  sigset_t all;
+  sigfillset(&all);
+  sigprocmask(SIG_BLOCK, &all, nullptr);
+
+  pthread_mutex_lock(&timer_lock);
+  for (;;)
+    {
+      l4_kernel_clock_t t_now = now();
+      while (heap_num && heap[0]->expiry <= t_now)
+        {
+          Posix_timer *t = heap[0];
+          l4_kernel_clock_t missed = 0;
+          if (t->interval)
+            {
+              // Late wakeups are merged into one notification.
+              missed = (t_now - t->expiry) / t->interval;
+              t->expiry += (missed + 1) * t->interval;
+              sift_down(0);
+            }
+          else
+            heap_remove(t);
+
+          t->overrun = missed > INT_MAX ? INT_MAX : missed;
+
+          // The timer may be deleted while we notify, so work on a copy.
+          struct sigevent ev = t->ev;
+          pthread_mutex_unlock(&timer_lock);
+          notify(ev);
+          pthread_mutex_lock(&timer_lock);
+          t_now = now();
+        }
+
+      l4_timeout_t to = L4_IPC_NEVER;
+      if (heap_num)
+        l4_rcv_timeout(l4_timeout_abs(heap[0]->expiry, 4), &to);
+
+      pthread_mutex_unlock(&timer_lock);
+      // Wakeups while we are not blocked are counted by the semaphore, so
+      // none of them is lost.
+      wakeup->down(to);
+      pthread_mutex_lock(&timer_lock);
+    }
+
+  return nullptr;
+}
+
+/// Start the service thread if necessary. Call with timer_lock held.
+int start_service()
+{
+  if (wakeup.is_valid())
+    return 0;
+
+  auto sem = L4Re::Util::cap_alloc.alloc<L4::Semaphore>();
+  if (!sem.is_valid())
+    return EAGAIN;
+
+  if (l4_error(L4Re::Env::env()->factory()->create(sem)) < 0)
+    {
+      L4Re::Util::cap_alloc.free(sem);
+      return EAGAIN;
+    }
+
+  wakeup = sem;
+
+  pthread_t th;
+  int err = pthread_create(&th, nullptr, service_thread, nullptr);
+  if (err)
+    {
+      L4Re::Util::cap_alloc.free(sem);
+      wakeup = L4::Cap<L4::Semaphore>::Invalid;
+      return EAGAIN;
+    }
+
+  pthread_detach(th);
+  return 0;
+}
+
+}
+
+extern "C"
+int timer_create(clockid_t clock_id, struct sigevent *__restrict evp,
+                 timer_t *__restrict timerid)
+noexcept(noexcept(timer_create(clock_id, evp, timerid)))
+{
+  if (clock_id != CLOCK_REALTIME && clock_id != CLOCK_MONOTONIC)
+    {
+      errno = EINVAL;
+      return -1;
+    }
+
+  auto *t = static_cast<Posix_timer *>(calloc(1, sizeof(Posix_timer)));
+  if (!t)
+    {
+      errno = EAGAIN;
+      return -1;
+    }
+
+  t->clock = clock_id;
+  if (evp)
+    t->ev = *evp;
+  else
+    {
+      t->ev.sigev_notify = SIGEV_SIGNAL;
+      t->ev.sigev_signo = SIGALRM;
+      t->ev.sigev_value.sival_ptr = t;
+    }
+
+  int err = 0;
+  switch (t->ev.sigev_notify)
+    {
+    case SIGEV_NONE:
+      break;
+    case SIGEV_SIGNAL:
+      if (t->ev.sigev_signo <= 0 || t->ev.sigev_signo >= _NSIG)
+        err = EINVAL;
+      else if (!L4Re::Env::env()->itas())
+        err = ENOTSUP;
+      break;
+    case SIGEV_THREAD:
+      if (!t->ev.sigev_notify_function)
+        err = EINVAL;
+      break;
+    default:
+      err = EINVAL;
+      break;
+    }
+
+  if (!err)
+    {
+      pthread_mutex_lock(&timer_lock);
+      err = start_service();
+      pthread_mutex_unlock(&timer_lock);
+    }
+
+  if (err)
+    {
+      free(t);
+      errno = err;
+      return -1;
+    }
+
+  *timerid = t;
+  return 0;
+}
+
+extern "C"
+int timer_delete(timer_t timerid)
+noexcept(noexcept(timer_delete(timerid)))
+{
+  auto *t = static_cast<Posix_timer *>(timerid);
+
+  pthread_mutex_lock(&timer_lock);
+  if (t->expiry)
+    heap_remove(t);
+  pthread_mutex_unlock(&timer_lock);
+
+  free(t);
+  return 0;
+}
+
+static void get_setting(Posix_timer const *t, l4_kernel_clock_t t_now,
+                        struct itimerspec *value)
+{
+  l4_kernel_clock_t left = 0;
+  if (t->expiry)
+    // An armed timer never reports a zero value.
+    left = t->expiry > t_now ? t->expiry - t_now : 1;
+
+  to_timespec(left, &value->it_value);
+  to_timespec(t->interval, &value->it_interval);
+}
+
+extern "C"
+int timer_settime(timer_t timerid, int flags,
+                  const struct itimerspec *__restrict value,
+                  struct itimerspec *__restrict ovalue)
+noexcept(noexcept(timer_settime(timerid, flags, value, ovalue)))
+{
+  auto *t = static_cast<Posix_timer *>(timerid);
+
+  if (!valid(value->it_value) || !valid(value->it_interval))
+    {
+      errno = EINVAL;
+      return -1;
+    }
+
+  l4_kernel_clock_t expiry = to_us(value->it_value);
+  l4_kernel_clock_t interval = to_us(value->it_interval);
+
+  pthread_mutex_lock(&timer_lock);
+  l4_kernel_clock_t t_now = now();
+
+  if (ovalue)
+    get_setting(t, t_now, ovalue);
+
+  if (t->expiry)
+    heap_remove(t);
+
+  t->interval = 0;
+  t->overrun = 0;
+
+  bool first = false;
+  if (expiry)
+    {
+      if (!(flags & TIMER_ABSTIME))
+        expiry += t_now;
+      else if (t->clock == CLOCK_REALTIME)
+        expiry -= __libc_l4_rt_clock_offset;
+
+      // Times before the start of the KIP clock wrap around. Like all times
+      // in the past they shall expire immediately. Note that a zero expiry
+      // marks a disarmed timer.
+      if (!expiry || expiry > (l4_kernel_clock_t)LLONG_MAX)
+        expiry = 1;
+
+      t->expiry = expiry;
+      t->interval = interval;
+      if (!heap_insert(t))
+        {
+          t->expiry = 0;
+          pthread_mutex_unlock(&timer_lock);
+          errno = EAGAIN;
+          return -1;
+        }
+      first = t->pos == 0;
+    }
+  pthread_mutex_unlock(&timer_lock);
+
+  if (first)
+    wakeup->up();
+
+  return 0;
+}
+
+extern "C"
+int timer_gettime(timer_t timerid, struct itimerspec *value)
+noexcept(noexcept(timer_gettime(timerid, value)))
+{
+  auto *t = static_cast<Posix_timer *>(timerid);
+
+  pthread_mutex_lock(&timer_lock);
+  get_setting(t, now(), value);
+  pthread_mutex_unlock(&timer_lock);
+  return 0;
+}
+
+extern "C"
+int timer_getoverrun(timer_t timerid)
+noexcept(noexcept(timer_getoverrun(timerid)))
+{
+  auto *t = static_cast<Posix_timer *>(timerid);
+
+  pthread_mutex_lock(&timer_lock);
+  int overrun = t->overrun;
+  pthread_mutex_unlock(&timer_lock);
+  return overrun;
+}
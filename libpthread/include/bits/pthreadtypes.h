@@ -72,10 +72,10 @@ typedef long __pthread_cond_align_t;
 
 typedef struct
 {
-  struct _pthread_fastlock __c_lock; /* Protect against concurrent access */
-  _pthread_descr __c_waiting;        /* Threads waiting on this condition */
+  struct _pthread_fastlock __c_lock; /* Status is the wake-up sequence */
+  void *__c_mutex;                   /* Mutex of the waiting threads */
   char __padding[48 - sizeof (struct _pthread_fastlock)
-		 - sizeof (_pthread_descr) - sizeof (__pthread_cond_align_t)];
+		 - sizeof (void *) - sizeof (__pthread_cond_align_t)];
   __pthread_cond_align_t __align;
 } pthread_cond_t;
 
@@ -121,10 +121,12 @@ typedef struct _pthread_rwlock_t
   struct _pthread_fastlock __rw_lock; /* Lock to guarantee mutual exclusion */
   int __rw_readers;                   /* Number of readers */
   _pthread_descr __rw_writer;         /* Identity of writer, or NULL if none */
-  _pthread_descr __rw_read_waiting;   /* Threads waiting for reading */
-  _pthread_descr __rw_write_waiting;  /* Threads waiting for writing */
+  long __rw_read_seq;                 /* Wake-up sequence of readers */
+  long __rw_write_seq;                /* Wake-up sequence of writers */
   int __rw_kind;                      /* Reader/Writer preference selection */
   int __rw_pshared;                   /* Shared between processes or not */
+  int __rw_read_waiters;              /* Number of waiting readers */
+  int __rw_write_waiters;             /* Number of waiting writers */
 } pthread_rwlock_t;
 
 
@@ -145,7 +147,7 @@ typedef struct {
   struct _pthread_fastlock __ba_lock; /* Lock to guarantee mutual exclusion */
   int __ba_required;                  /* Threads needed for completion */
   int __ba_present;                   /* Threads waiting */
-  _pthread_descr __ba_waiting;        /* Queue of waiting threads */
+  long __ba_generation;               /* Advanced on each completion */
 } pthread_barrier_t;
 
 /* barrier attribute */
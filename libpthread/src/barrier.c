@@ -18,55 +18,50 @@
    not, see <http://www.gnu.org/licenses/>.  */
 
 #include <errno.h>
+#include <limits.h>
 #include "pthread.h"
 #include "internals.h"
 #include "spinlock.h"
-#include "queue.h"
-#include "restart.h"
+
+/* The futex lock on the status of __ba_lock protects the barrier. The
+   waiting threads wait for the generation to advance, which is done by the
+   serial thread. */
 
 int
 pthread_barrier_wait(pthread_barrier_t *barrier)
 {
-  pthread_descr self = thread_self();
-  pthread_descr temp_wake_queue, th;
+  long generation;
   int result = 0;
 
-  __pthread_lock(&barrier->__ba_lock, self);
+  __pthread_futex_lock(&barrier->__ba_lock.__status, NULL);
 
   /* If the required number of threads have achieved rendezvous... */
   if (barrier->__ba_present >= barrier->__ba_required - 1)
     {
       /* ... then this last caller shall be the serial thread */
       result = PTHREAD_BARRIER_SERIAL_THREAD;
-      /* Copy and clear wait queue and reset barrier. */
-      temp_wake_queue = barrier->__ba_waiting;
-      barrier->__ba_waiting = NULL;
+      /* Reset barrier and start the next round. */
       barrier->__ba_present = 0;
-    }
-  else
-    {
-      result = 0;
-      barrier->__ba_present++;
-      enqueue(&barrier->__ba_waiting, self);
-    }
-
-  __pthread_unlock(&barrier->__ba_lock);
+      __atomic_add_fetch(&barrier->__ba_generation, 1, __ATOMIC_RELEASE);
+      __pthread_futex_unlock(&barrier->__ba_lock.__status);
 
-  if (result == 0)
-    {
-      /* Non-serial threads have to suspend */
-      suspend(self);
-      /* We don't bother dealing with cancellation because the POSIX
-         spec for barriers doesn't mention that pthread_barrier_wait
-         is a cancellation point. */
-    }
-  else
-    {
       /* Serial thread wakes up all others. */
-      while ((th = dequeue(&temp_wake_queue)) != NULL)
-	restart(th);
+      __pthread_futex_wake(&barrier->__ba_generation, INT_MAX);
+      return result;
     }
 
+  barrier->__ba_present++;
+  generation = barrier->__ba_generation;
+
+  /* Non-serial threads have to wait. We don't bother dealing with
+     cancellation because the POSIX spec for barriers doesn't mention that
+     pthread_barrier_wait is a cancellation point. The thread is queued
+     before the lock is released, so the serial thread wakes it without
+     further ado. It must not touch the barrier after that, the serial
+     thread may already have returned and destroyed it. */
+  __pthread_futex_wait_unlock(&barrier->__ba_generation, generation,
+                              &barrier->__ba_lock.__status);
+
   return result;
 }
 
@@ -81,14 +76,14 @@ pthread_barrier_init(pthread_barrier_t *barrier,
   __pthread_init_lock(&barrier->__ba_lock);
   barrier->__ba_required = count;
   barrier->__ba_present = 0;
-  barrier->__ba_waiting = NULL;
+  barrier->__ba_generation = 0;
   return 0;
 }
 
 int
 pthread_barrier_destroy(pthread_barrier_t *barrier)
 {
-  if (barrier->__ba_waiting != NULL) return EBUSY;
+  if (barrier->__ba_present > 0) return EBUSY;
   return 0;
 }
 
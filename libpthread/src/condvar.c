@@ -16,6 +16,7 @@
 /* Condition variables */
 
 #include <errno.h>
+#include <limits.h>
 #include <sched.h>
 #include <stddef.h>
 #include <sys/time.h>
@@ -27,50 +28,40 @@
 
 #include <l4/sys/compiler.h>
 
+/* A condition variable is a sequence number in the status of its lock,
+   advanced by every signal. Waiters wait for it to change, so a signal
+   given between releasing the mutex and going to sleep is not lost. A
+   broadcast wakes a single waiter and moves the others to the futex word
+   of the mutex, they are woken one by one as the mutex is released. */
+
 int
 L4_HIDDEN
 __pthread_cond_init(pthread_cond_t *cond,
                     const pthread_condattr_t *cond_attr __attribute__((unused)))
 {
   __pthread_init_lock(&cond->__c_lock);
-  cond->__c_waiting = NULL;
+  cond->__c_mutex = NULL;
   return 0;
 }
 L4_STRONG_ALIAS(__pthread_cond_init, pthread_cond_init)
 
 int
 L4_HIDDEN
-__pthread_cond_destroy(pthread_cond_t *cond)
+__pthread_cond_destroy(pthread_cond_t *cond __attribute__((unused)))
 {
-  if (cond->__c_waiting != NULL) return EBUSY;
+  /* Waiters only use the address of the sequence after waking up. */
   return 0;
 }
 L4_STRONG_ALIAS(__pthread_cond_destroy, pthread_cond_destroy)
 
-/* Function called by pthread_cancel to remove the thread from
-   waiting on a condition variable queue. */
-
-static int cond_extricate_func(void *obj, pthread_descr th)
-{
-  volatile pthread_descr self = thread_self();
-  pthread_cond_t *cond = obj;
-  int did_remove = 0;
-
-  __pthread_lock(&cond->__c_lock, self);
-  did_remove = remove_from_queue(&cond->__c_waiting, th);
-  __pthread_unlock(&cond->__c_lock);
-
-  return did_remove;
-}
-
-int
-L4_HIDDEN
-__pthread_cond_wait(pthread_cond_t *cond, pthread_mutex_t *mutex)
+static int
+cond_wait(pthread_cond_t *cond, pthread_mutex_t *mutex,
+          const struct timespec *abstime)
 {
-  volatile pthread_descr self = thread_self();
-  pthread_extricate_if extr;
-  int already_canceled = 0;
-  int spurious_wakeup_count;
+  pthread_descr self = thread_self();
+  long seq;
+  int count;
+  int res;
 
   /* Check whether the mutex is locked and owned by this thread.  */
   if (mutex->__m_kind != PTHREAD_MUTEX_TIMED_NP
@@ -78,173 +69,35 @@ __pthread_cond_wait(pthread_cond_t *cond, pthread_mutex_t *mutex)
       && mutex->__m_owner != self)
     return EINVAL;
 
-  /* Set up extrication interface */
-  extr.pu_object = cond;
-  extr.pu_extricate_func = cond_extricate_func;
-
-  /* Register extrication interface */
-  THREAD_SETMEM(self, p_condvar_avail, 0);
-  __pthread_set_own_extricate_if(self, &extr);
-
-  /* Atomically enqueue thread for waiting, but only if it is not
-     canceled. If the thread is canceled, then it will fall through the
-     suspend call below, and then call pthread_exit without
-     having to worry about whether it is still on the condition variable queue.
-     This depends on pthread_cancel setting p_canceled before calling the
-     extricate function. */
-
-  __pthread_lock(&cond->__c_lock, self);
-  if (!(THREAD_GETMEM(self, p_canceled)
-      && THREAD_GETMEM(self, p_cancelstate) == PTHREAD_CANCEL_ENABLE))
-    enqueue(&cond->__c_waiting, self);
-  else
-    already_canceled = 1;
-  __pthread_unlock(&cond->__c_lock);
-
-  if (already_canceled) {
-    __pthread_set_own_extricate_if(self, 0);
-    __pthread_do_exit(PTHREAD_CANCELED, CURRENT_STACK_FRAME);
-  }
-
-  pthread_mutex_unlock(mutex);
+  seq = __atomic_load_n(&cond->__c_lock.__status, __ATOMIC_ACQUIRE);
+  __atomic_store_n(&cond->__c_mutex, mutex, __ATOMIC_RELAXED);
 
-  spurious_wakeup_count = 0;
-  while (1)
-    {
-      suspend(self);
-      if (THREAD_GETMEM(self, p_condvar_avail) == 0
-	  && (THREAD_GETMEM(self, p_woken_by_cancel) == 0
-	      || THREAD_GETMEM(self, p_cancelstate) != PTHREAD_CANCEL_ENABLE))
-	{
-	  /* Count resumes that don't belong to us. */
-	  spurious_wakeup_count++;
-	  continue;
-	}
-      break;
-    }
+  count = __pthread_mutex_cond_unlock(mutex);
+  res = __pthread_futex_wait(&cond->__c_lock.__status, seq, abstime, 1);
+  __pthread_mutex_cond_lock(mutex, count);
 
-  __pthread_set_own_extricate_if(self, 0);
-
-  /* Check for cancellation again, to provide correct cancellation
-     point behavior */
-
-  if (THREAD_GETMEM(self, p_woken_by_cancel)
-      && THREAD_GETMEM(self, p_cancelstate) == PTHREAD_CANCEL_ENABLE) {
-    THREAD_SETMEM(self, p_woken_by_cancel, 0);
-    pthread_mutex_lock(mutex);
+  /* Like in other cancellable waits, the canceled thread exits with the
+     mutex locked. */
+  if (res == ECANCELED)
     __pthread_do_exit(PTHREAD_CANCELED, CURRENT_STACK_FRAME);
-  }
-
-  /* Put back any resumes we caught that don't belong to us. */
-  while (spurious_wakeup_count--)
-    restart(self);
 
-  pthread_mutex_lock(mutex);
-  return 0;
+  return res == ETIMEDOUT ? ETIMEDOUT : 0;
 }
-L4_STRONG_ALIAS(__pthread_cond_wait, pthread_cond_wait)
 
-static int
-pthread_cond_timedwait_relative(pthread_cond_t *cond,
-				pthread_mutex_t *mutex,
-				const struct timespec * abstime)
+int
+L4_HIDDEN
+__pthread_cond_wait(pthread_cond_t *cond, pthread_mutex_t *mutex)
 {
-  __volatile__ pthread_descr self = thread_self();
-  int already_canceled = 0;
-  pthread_extricate_if extr;
-  int spurious_wakeup_count;
-
-  /* Check whether the mutex is locked and owned by this thread.  */
-  if (mutex->__m_kind != PTHREAD_MUTEX_TIMED_NP
-      && mutex->__m_kind != PTHREAD_MUTEX_ADAPTIVE_NP
-      && mutex->__m_owner != self)
-    return EINVAL;
-
-  /* Set up extrication interface */
-  extr.pu_object = cond;
-  extr.pu_extricate_func = cond_extricate_func;
-
-  /* Register extrication interface */
-  THREAD_SETMEM(self, p_condvar_avail, 0);
-  __pthread_set_own_extricate_if(self, &extr);
-
-  /* Enqueue to wait on the condition and check for cancellation. */
-  __pthread_lock(&cond->__c_lock, self);
-  if (!(THREAD_GETMEM(self, p_canceled)
-      && THREAD_GETMEM(self, p_cancelstate) == PTHREAD_CANCEL_ENABLE))
-    enqueue(&cond->__c_waiting, self);
-  else
-    already_canceled = 1;
-  __pthread_unlock(&cond->__c_lock);
-
-  if (already_canceled) {
-    __pthread_set_own_extricate_if(self, 0);
-    __pthread_do_exit(PTHREAD_CANCELED, CURRENT_STACK_FRAME);
-  }
-
-  pthread_mutex_unlock(mutex);
-
-  spurious_wakeup_count = 0;
-  while (1)
-    {
-      if (!timedsuspend(self, abstime)) {
-	int was_on_queue;
-
-	/* __pthread_lock will queue back any spurious restarts that
-	   may happen to it. */
-
-	__pthread_lock(&cond->__c_lock, self);
-	was_on_queue = remove_from_queue(&cond->__c_waiting, self);
-	__pthread_unlock(&cond->__c_lock);
-
-	if (was_on_queue) {
-	  __pthread_set_own_extricate_if(self, 0);
-	  pthread_mutex_lock(mutex);
-	  return ETIMEDOUT;
-	}
-
-	/* Eat the outstanding restart() from the signaller */
-	suspend(self);
-      }
-
-      if (THREAD_GETMEM(self, p_condvar_avail) == 0
-	  && (THREAD_GETMEM(self, p_woken_by_cancel) == 0
-	      || THREAD_GETMEM(self, p_cancelstate) != PTHREAD_CANCEL_ENABLE))
-	{
-	  /* Count resumes that don't belong to us. */
-	  spurious_wakeup_count++;
-	  continue;
-	}
-      break;
-    }
-
-  __pthread_set_own_extricate_if(self, 0);
-
-  /* The remaining logic is the same as in other cancellable waits,
-     such as pthread_join sem_wait or pthread_cond wait. */
-
-  if (THREAD_GETMEM(self, p_woken_by_cancel)
-      && THREAD_GETMEM(self, p_cancelstate) == PTHREAD_CANCEL_ENABLE) {
-    THREAD_SETMEM(self, p_woken_by_cancel, 0);
-    pthread_mutex_lock(mutex);
-    __pthread_do_exit(PTHREAD_CANCELED, CURRENT_STACK_FRAME);
-  }
-
-  /* Put back any resumes we caught that don't belong to us. */
-  while (spurious_wakeup_count--)
-    restart(self);
-
-  pthread_mutex_lock(mutex);
-  return 0;
+  return cond_wait(cond, mutex, NULL);
 }
+L4_STRONG_ALIAS(__pthread_cond_wait, pthread_cond_wait)
 
 int
 L4_HIDDEN
 __pthread_cond_timedwait(pthread_cond_t *cond, pthread_mutex_t *mutex,
 			     const struct timespec * abstime)
 {
-  /* Indirect call through pointer! */
-  return pthread_cond_timedwait_relative(cond, mutex, abstime);
+  return cond_wait(cond, mutex, abstime);
 }
 L4_STRONG_ALIAS(__pthread_cond_timedwait, pthread_cond_timedwait)
 
@@ -252,16 +105,8 @@ int
 L4_HIDDEN
 __pthread_cond_signal(pthread_cond_t *cond)
 {
-  pthread_descr th;
-
-  __pthread_lock(&cond->__c_lock, NULL);
-  th = dequeue(&cond->__c_waiting);
-  __pthread_unlock(&cond->__c_lock);
-  if (th != NULL) {
-    th->p_condvar_avail = 1;
-    WRITE_MEMORY_BARRIER();
-    restart(th);
-  }
+  __atomic_add_fetch(&cond->__c_lock.__status, 1, __ATOMIC_RELEASE);
+  __pthread_futex_wake(&cond->__c_lock.__status, 1);
   return 0;
 }
 L4_STRONG_ALIAS(__pthread_cond_signal, pthread_cond_signal)
@@ -270,19 +115,15 @@ int
 L4_HIDDEN
 __pthread_cond_broadcast(pthread_cond_t *cond)
 {
-  pthread_descr tosignal, th;
+  pthread_mutex_t *mutex;
 
-  __pthread_lock(&cond->__c_lock, NULL);
-  /* Copy the current state of the waiting queue and empty it */
-  tosignal = cond->__c_waiting;
-  cond->__c_waiting = NULL;
-  __pthread_unlock(&cond->__c_lock);
-  /* Now signal each process in the queue */
-  while ((th = dequeue(&tosignal)) != NULL) {
-    th->p_condvar_avail = 1;
-    WRITE_MEMORY_BARRIER();
-    restart(th);
-  }
+  __atomic_add_fetch(&cond->__c_lock.__status, 1, __ATOMIC_RELEASE);
+  mutex = __atomic_load_n(&cond->__c_mutex, __ATOMIC_RELAXED);
+  if (mutex != NULL)
+    __pthread_futex_requeue(&cond->__c_lock.__status, 1,
+                            &mutex->__m_lock.__status);
+  else
+    __pthread_futex_wake(&cond->__c_lock.__status, INT_MAX);
   return 0;
 }
 L4_STRONG_ALIAS(__pthread_cond_broadcast, pthread_cond_broadcast)
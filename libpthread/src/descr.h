@@ -147,7 +147,7 @@ struct pthread
   struct pthread_atomic p_resume_count; /* number of times restart() was
 					   called on thread */
   char p_woken_by_cancel;       /* cancellation performed wakeup */
-  char p_condvar_avail;		/* flag if conditional variable became avail */
+  char p_futex_woken;		/* flag if woken by __pthread_futex_wake */
   char p_sem_avail;             /* flag if semaphore became available */
   pthread_extricate_if *p_extricate; /* See above */
   pthread_readlock_info *p_readlock_list;  /* List of readlock info structs */
@@ -155,6 +155,8 @@ struct pthread
   int p_untracked_readlock_count;	/* Readlocks not tracked by list */
   int p_inheritsched;           /* copied from the thread attribute */
   char *p_stackaddr;		/* Stack address.  */
+  pthread_descr p_nextzombie;   /* Next exited detached thread to be freed */
+  long *p_futex_addr;           /* Address waited for in __pthread_futex_wait */
   /* New elements must be added at the end.  */
 
 #if defined(CONFIG_L4_LIBC_MUSL) && !defined(TLS_PTHREAD_LIBC_DATA_AT_HEAD)
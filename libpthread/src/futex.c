@@ -0,0 +1,353 @@
+/*
+ * Copyright (C) 2026 Kernkonzept GmbH.
+ *
+ * License: see LICENSE.spdx (in this directory or the directories above)
+ */
+
+/* Address-keyed wait and wake-up
+
+   A futex emulation on top of the semaphore every thread already has.
+   Waiting threads are kept in a fixed number of queues, selected by a hash
+   of the address they wait for. Like the other waiting queues, each queue
+   is sorted by decreasing priority, so wake-ups go to the most important
+   waiter first. A waker removes the waiters from the queue and sets their
+   p_futex_woken flag before restarting them, so each wait consumes exactly
+   the restart meant for it.
+
+   The addresses are only used as keys, they are never dereferenced after
+   the comparison in __pthread_futex_wait(). So an object may be destroyed
+   while a wake-up for it is still in progress. */
+
+#include <errno.h>
+#include <limits.h>
+#include "pthread.h"
+#include "internals.h"
+#include "spinlock.h"
+#include "queue.h"
+#include "restart.h"
+
+#include <l4/sys/compiler.h>
+
+#define FUTEX_HASH_BITS 7
+
+struct futex_bucket
+{
+  struct _pthread_fastlock lock;
+  pthread_descr waiting;
+};
+
+static struct futex_bucket futex_buckets[1 << FUTEX_HASH_BITS];
+
+static struct futex_bucket *futex_bucket(long *addr)
+{
+  unsigned long h = (unsigned long) addr / sizeof(long);
+  h ^= h >> FUTEX_HASH_BITS;
+  h ^= h >> (2 * FUTEX_HASH_BITS);
+  return &futex_buckets[h & ((1 << FUTEX_HASH_BITS) - 1)];
+}
+
+/* Lock the queue of a waiting thread. The address the thread waits for
+   changes when it is requeued, so check it again with the queue locked. */
+
+static struct futex_bucket *futex_lock_waiter(pthread_descr th)
+{
+  for (;;)
+    {
+      long *addr = __atomic_load_n(&th->p_futex_addr, __ATOMIC_RELAXED);
+      struct futex_bucket *b = futex_bucket(addr);
+
+      __pthread_lock(&b->lock, NULL);
+      if (th->p_futex_addr == addr)
+        return b;
+      __pthread_unlock(&b->lock);
+    }
+}
+
+/* Function called by pthread_cancel to remove the thread from the queue. */
+
+static int futex_extricate_func(void *obj __attribute__((unused)),
+                                pthread_descr th)
+{
+  struct futex_bucket *b = futex_lock_waiter(th);
+  int did_remove = remove_from_queue(&b->waiting, th);
+  __pthread_unlock(&b->lock);
+
+  return did_remove;
+}
+
+/* Move up to `count` waiters for `addr` from queue `q` to the list `woken`,
+   which keeps the order of the queue. */
+
+static int futex_dequeue(pthread_descr *q, long *addr, int count,
+                         pthread_descr **woken_tail)
+{
+  int n = 0;
+
+  while (*q != NULL && n < count)
+    {
+      pthread_descr th = *q;
+      if (th->p_futex_addr != addr)
+        {
+          q = &th->p_nextwaiting;
+          continue;
+        }
+
+      *q = th->p_nextwaiting;
+      th->p_nextwaiting = NULL;
+      **woken_tail = th;
+      *woken_tail = &th->p_nextwaiting;
+      n++;
+    }
+
+  return n;
+}
+
+static void futex_restart(pthread_descr woken)
+{
+  pthread_descr th;
+
+  while ((th = woken) != NULL)
+    {
+      woken = th->p_nextwaiting;
+      th->p_nextwaiting = NULL;
+      /* The thread may return as soon as it sees the flag. */
+      __atomic_store_n(&th->p_futex_woken, 1, __ATOMIC_RELEASE);
+      restart(th);
+    }
+}
+
+/* Block while *addr equals val. If unlock is not NULL, it is a futex lock
+   held by the caller, which is released once the thread is queued. */
+
+static int futex_wait(long *addr, long val, const struct timespec *abstime,
+                      int cancellable, long *unlock)
+{
+  volatile pthread_descr self = thread_self();
+  struct futex_bucket *b = futex_bucket(addr);
+  pthread_extricate_if extr;
+  int spurious_wakeup_count;
+  int res = 0;
+
+  if (cancellable)
+    {
+      extr.pu_object = NULL;
+      extr.pu_extricate_func = futex_extricate_func;
+      __pthread_set_own_extricate_if(self, &extr);
+    }
+
+  /* Publish the address before looking at p_canceled, pthread_cancel does
+     it the other way round. */
+  __atomic_store_n(&self->p_futex_addr, addr, __ATOMIC_SEQ_CST);
+
+  __pthread_lock(&b->lock, self);
+
+  /* Like for the other cancellable waits, pthread_cancel sets p_canceled
+     before calling the extricate function, so a thread that is not queued
+     yet sees the request here. */
+  if (cancellable
+      && THREAD_GETMEM(self, p_canceled)
+      && THREAD_GETMEM(self, p_cancelstate) == PTHREAD_CANCEL_ENABLE)
+    res = ECANCELED;
+  else if (__atomic_load_n(addr, __ATOMIC_ACQUIRE) != val)
+    res = EAGAIN;
+  else
+    {
+      THREAD_SETMEM(self, p_futex_woken, 0);
+      enqueue(&b->waiting, self);
+    }
+
+  __pthread_unlock(&b->lock);
+
+  if (unlock != NULL)
+    __pthread_futex_unlock(unlock);
+
+  if (res)
+    {
+      if (cancellable)
+        __pthread_set_own_extricate_if(self, 0);
+      return res;
+    }
+
+  spurious_wakeup_count = 0;
+  while (1)
+    {
+      if (abstime == NULL)
+        suspend(self);
+      else if (!timedsuspend(self, abstime))
+        {
+          int was_on_queue;
+
+          b = futex_lock_waiter(self);
+          was_on_queue = remove_from_queue(&b->waiting, self);
+          __pthread_unlock(&b->lock);
+
+          if (was_on_queue)
+            {
+              res = ETIMEDOUT;
+              break;
+            }
+
+          /* Eat the outstanding restart() from the waker */
+          suspend(self);
+        }
+
+      if (__atomic_load_n(&self->p_futex_woken, __ATOMIC_ACQUIRE))
+        break;
+
+      if (cancellable
+          && THREAD_GETMEM(self, p_woken_by_cancel)
+          && THREAD_GETMEM(self, p_cancelstate) == PTHREAD_CANCEL_ENABLE)
+        {
+          THREAD_SETMEM(self, p_woken_by_cancel, 0);
+          res = ECANCELED;
+          break;
+        }
+
+      /* Count resumes that don't belong to us. */
+      spurious_wakeup_count++;
+    }
+
+  if (cancellable)
+    __pthread_set_own_extricate_if(self, 0);
+
+  /* Put back any resumes we caught that don't belong to us. */
+  while (spurious_wakeup_count--)
+    restart(self);
+
+  return res;
+}
+
+/* Block while *addr equals val.
+
+   Returns 0 when woken, EAGAIN if *addr did not match, ETIMEDOUT when
+   abstime passed and ECANCELED if a cancellable wait was canceled. A
+   canceled thread has to act on the cancellation itself. */
+
+int
+L4_HIDDEN
+__pthread_futex_wait(long *addr, long val, const struct timespec *abstime,
+                     int cancellable)
+{
+  return futex_wait(addr, val, abstime, cancellable, NULL);
+}
+
+/* Like __pthread_futex_wait() without timeout and cancellation, but release
+   the futex lock `lock` once the thread is queued. Waking up needs no
+   access to the object holding addr and lock, so it may be destroyed as
+   soon as the thread is woken. */
+
+int
+L4_HIDDEN
+__pthread_futex_wait_unlock(long *addr, long val, long *lock)
+{
+  return futex_wait(addr, val, NULL, 0, lock);
+}
+
+/* Wake up to count threads waiting for addr, return how many. */
+
+int
+L4_HIDDEN
+__pthread_futex_wake(long *addr, int count)
+{
+  struct futex_bucket *b = futex_bucket(addr);
+  pthread_descr woken = NULL, *tail = &woken;
+  int n;
+
+  __pthread_lock(&b->lock, NULL);
+  n = futex_dequeue(&b->waiting, addr, count, &tail);
+  __pthread_unlock(&b->lock);
+
+  futex_restart(woken);
+  return n;
+}
+
+/* Wake up to count threads waiting for addr and let the remaining ones wait
+   for addr2 instead, without waking them. Return the number of woken
+   threads. */
+
+int
+L4_HIDDEN
+__pthread_futex_requeue(long *addr, int count, long *addr2)
+{
+  struct futex_bucket *b = futex_bucket(addr);
+  struct futex_bucket *b2 = futex_bucket(addr2);
+  pthread_descr woken = NULL, *tail = &woken;
+  pthread_descr moved = NULL, *moved_tail = &moved;
+  pthread_descr th;
+  int n;
+
+  /* Lock the queues in a fixed order. */
+  if (b < b2)
+    {
+      __pthread_lock(&b->lock, NULL);
+      __pthread_lock(&b2->lock, NULL);
+    }
+  else
+    {
+      __pthread_lock(&b2->lock, NULL);
+      if (b != b2)
+        __pthread_lock(&b->lock, NULL);
+    }
+
+  n = futex_dequeue(&b->waiting, addr, count, &tail);
+  futex_dequeue(&b->waiting, addr, INT_MAX, &moved_tail);
+
+  while ((th = dequeue(&moved)) != NULL)
+    {
+      __atomic_store_n(&th->p_futex_addr, addr2, __ATOMIC_RELAXED);
+      enqueue(&b2->waiting, th);
+    }
+
+  __pthread_unlock(&b->lock);
+  if (b != b2)
+    __pthread_unlock(&b2->lock);
+
+  futex_restart(woken);
+  return n;
+}
+
+/* Locks on a futex word: 0 is free, 1 is taken and 2 is taken with
+   possible waiters. Only the unlock of a lock in state 2 wakes a waiter. */
+
+int
+L4_HIDDEN
+__pthread_futex_lock(long *lock, const struct timespec *abstime)
+{
+  long c = 0;
+
+  if (__atomic_compare_exchange_n(lock, &c, 1, 0, __ATOMIC_ACQUIRE,
+                                  __ATOMIC_RELAXED))
+    return 0;
+
+  if (c != 2)
+    c = __atomic_exchange_n(lock, 2, __ATOMIC_ACQUIRE);
+
+  while (c != 0)
+    {
+      if (__pthread_futex_wait(lock, 2, abstime, 0) == ETIMEDOUT)
+        return ETIMEDOUT;
+      c = __atomic_exchange_n(lock, 2, __ATOMIC_ACQUIRE);
+    }
+
+  return 0;
+}
+
+/* Take the lock as a thread that may have been requeued to it. Such a
+   thread cannot know whether others wait, so it always marks the lock
+   contended. */
+
+void
+L4_HIDDEN
+__pthread_futex_lock_contended(long *lock)
+{
+  while (__atomic_exchange_n(lock, 2, __ATOMIC_ACQUIRE) != 0)
+    __pthread_futex_wait(lock, 2, NULL, 0);
+}
+
+void
+L4_HIDDEN
+__pthread_futex_unlock(long *lock)
+{
+  if (__atomic_exchange_n(lock, 0, __ATOMIC_RELEASE) == 2)
+    __pthread_futex_wake(lock, 1);
+}
@@ -33,6 +33,7 @@
 
 #include <l4/sys/compiler.h>
 #include <l4/sys/ipc.h>
+#include <l4/sys/scheduler.h>
 
 #include "descr.h"
 
@@ -81,24 +82,16 @@ typedef l4_utcb_t *pthread_handle;
 
 /* The type of messages sent to the thread manager thread */
 
+/* Thread creation, exit and freeing do not involve the manager thread. */
 enum pthread_request_rq {                        /* Request kind */
-    REQ_CREATE, REQ_FREE, REQ_PROCESS_EXIT, REQ_MAIN_THREAD_EXIT,
-    REQ_POST, REQ_DEBUG, REQ_KICK, REQ_EXEC_IN_MANAGER,
-    REQ_THREAD_EXIT
+    REQ_PROCESS_EXIT, REQ_MAIN_THREAD_EXIT,
+    REQ_POST, REQ_DEBUG, REQ_KICK, REQ_EXEC_IN_MANAGER
 };
 
 struct pthread_request {
   pthread_descr req_thread;     /* Thread doing the request */
   enum pthread_request_rq req_kind;
   union {                       /* Arguments for request */
-    struct {                    /* For REQ_CREATE: */
-      const pthread_attr_t * attr; /* thread attributes */
-      void * (*fn)(void *);     /*   start function */
-      void * arg;               /*   argument to start function */
-    } create;
-    struct {                    /* For REQ_FREE: */
-      pthread_t thread_id;      /*   identifier of thread to free */
-    } free;
     struct {                    /* For REQ_PROCESS_EXIT: */
       int code;                 /*   exit status */
     } exit;
@@ -345,6 +338,33 @@ extern void __flockfilelist (void);
 extern void __funlockfilelist (void);
 extern void __fresetlockfiles (void);
 extern void __pthread_manager_adjust_prio (int thread_prio);
+extern int __pthread_create_thread (pthread_descr creator,
+                                    const pthread_attr_t *attr,
+                                    void * (*start_routine)(void *),
+                                    void *arg) L4_HIDDEN;
+extern void __pthread_unlink_thread (pthread_descr th) L4_HIDDEN;
+extern void __pthread_release_thread (pthread_descr th, int detached)
+     L4_HIDDEN __attribute__ ((__noreturn__));
+extern void __pthread_free_thread (pthread_t th_id) L4_HIDDEN;
+
+/* Address-keyed wait and wake-up (futex.c) */
+extern int __pthread_futex_wait (long *addr, long val,
+                                 const struct timespec *abstime,
+                                 int cancellable) L4_HIDDEN;
+extern int __pthread_futex_wait_unlock (long *addr, long val, long *lock)
+     L4_HIDDEN;
+extern int __pthread_futex_wake (long *addr, int count) L4_HIDDEN;
+extern int __pthread_futex_requeue (long *addr, int count, long *addr2)
+     L4_HIDDEN;
+extern int __pthread_futex_lock (long *lock, const struct timespec *abstime)
+     L4_HIDDEN;
+extern void __pthread_futex_lock_contended (long *lock) L4_HIDDEN;
+extern void __pthread_futex_unlock (long *lock) L4_HIDDEN;
+
+/* Mutex operations around waiting on a condition (mutex.c) */
+extern int __pthread_mutex_cond_unlock (pthread_mutex_t *mutex) L4_HIDDEN;
+extern void __pthread_mutex_cond_lock (pthread_mutex_t *mutex, int count)
+     L4_HIDDEN;
 extern void __pthread_initialize_minimal (void *arg);
 
 extern int __pthread_attr_setguardsize (pthread_attr_t *__attr,
@@ -577,6 +597,17 @@ static inline int __pthread_l4_getprio(int policy, int posix_prio)
     }
 }
 
+/* Affinity to pass to run_thread(). A mask of all ones means the thread was
+   never restricted, it may then also run on CPUs beyond the mask. */
+static inline l4_sched_cpu_set_t __pthread_l4_affinity(pthread_descr th);
+static inline l4_sched_cpu_set_t __pthread_l4_affinity(pthread_descr th)
+{
+  if (th->p_affinity_mask[0] == ~0ul)
+    return l4_sched_cpu_set(0, ~0, 1);
+
+  return l4_sched_cpu_set(0, 0, th->p_affinity_mask[0]);
+}
+
 
 static inline pthread_descr
 check_thread_self (void);
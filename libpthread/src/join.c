@@ -39,6 +39,7 @@ __pthread_do_exit(void *retval, char *currentframe)
 {
   pthread_descr self = thread_self();
   pthread_descr joining;
+  int detached;
   struct pthread_request request;
 
   /* Reset the cancellation flag to avoid looping if the cleanup handlers
@@ -47,13 +48,19 @@ __pthread_do_exit(void *retval, char *currentframe)
   /* Call cleanup functions and destroy the thread-specific data */
   __pthread_perform_cleanup(currentframe);
   __pthread_destroy_specifics();
+  /* Leave the list of live threads before anyone can see us terminated */
+  if (self != __pthread_main_thread)
+    __pthread_unlink_thread(self);
   /* Store return value */
   __pthread_lock(THREAD_GETMEM(self, p_lock), self);
   THREAD_SETMEM(self, p_retval, retval);
   /* Say that we've terminated */
   THREAD_SETMEM(self, p_terminated, 1);
+  if (self != __pthread_main_thread)
+    THREAD_SETMEM(self, p_exited, 1);
   /* See if someone is joining on us */
   joining = THREAD_GETMEM(self, p_joining);
+  detached = THREAD_GETMEM(self, p_detached);
   __pthread_unlock(THREAD_GETMEM(self, p_lock));
   /* Restart joining thread if any */
   if (joining != NULL)
@@ -80,11 +87,7 @@ __pthread_do_exit(void *retval, char *currentframe)
 
   //_exit(0);
 
-  request.req_thread = self;
-  request.req_kind = REQ_THREAD_EXIT;
-  __pthread_send_manager_rq(&request, 1);
-
-  l4_sleep_forever();
+  __pthread_release_thread(self, detached);
 }
 
 /* Function called by pthread_cancel to remove the thread from
@@ -109,7 +112,6 @@ static int join_extricate_func(void *obj, pthread_descr th)
 int pthread_join(pthread_t thread_id, void ** thread_return)
 {
   __volatile__ pthread_descr self = thread_self();
-  struct pthread_request request;
   pthread_handle handle = thread_handle(thread_id);
   pthread_descr th;
   pthread_extricate_if extr;
@@ -165,20 +167,13 @@ int pthread_join(pthread_t thread_id, void ** thread_return)
   /* Get return value */
   if (thread_return != NULL) *thread_return = th->p_retval;
   __pthread_unlock(handle_to_lock(handle));
-  /* Send notification to thread manager */
-  if (__pthread_manager_request >= 0) {
-    request.req_thread = self;
-    request.req_kind = REQ_FREE;
-    request.req_args.free.thread_id = thread_id;
-    __pthread_send_manager_rq(&request, 0);
-  }
+  __pthread_free_thread(thread_id);
   return 0;
 }
 
 int pthread_detach(pthread_t thread_id)
 {
   int exited;
-  struct pthread_request request;
   pthread_handle handle = thread_handle(thread_id);
   pthread_descr th;
 
@@ -202,12 +197,8 @@ int pthread_detach(pthread_t thread_id)
   th->p_detached = 1;
   exited = th->p_exited;
   __pthread_unlock(handle_to_lock(handle));
-  /* If already terminated, notify thread manager to reclaim resources */
-  if (exited && __pthread_manager_request >= 0) {
-    request.req_thread = thread_self();
-    request.req_kind = REQ_FREE;
-    request.req_args.free.thread_id = thread_id;
-    __pthread_send_manager_rq(&request, 0);
-  }
+  /* If already terminated, reclaim its resources */
+  if (exited)
+    __pthread_free_thread(thread_id);
   return 0;
 }
@@ -15,6 +15,7 @@
 
 #include <pthread-l4.h>
 #include <errno.h>
+#include <string.h>
 #include "spinlock.h"
 
 #include "l4.h"
@@ -161,6 +162,7 @@ noexcept(noexcept(__pthread_setschedparam(thread, policy, param)))
     {
       L4::Cap<L4::Thread> t(th->p_th_cap);
       l4_sched_param_t sp = l4_sched_param(prio, 0);
+      sp.affinity = __pthread_l4_affinity(th);
       L4Re::Env::env()->scheduler()->run_thread(t, sp);
     }
   __pthread_unlock(handle_to_lock(handle));
@@ -204,6 +206,13 @@ int pthread_setaffinity_np(pthread_t __th, size_t __cpusetsize,
   if (__cpusetsize < sizeof(__cpuset->__bits[0]))
     return EINVAL;
 
+  // Only the first word of the set can be passed to the scheduler.
+  if (!__cpuset->__bits[0])
+    return EINVAL;
+  for (size_t i = 1; i < __cpusetsize / sizeof(__cpuset->__bits[0]); ++i)
+    if (__cpuset->__bits[i])
+      return EINVAL;
+
   __pthread_lock(handle_to_lock(handle), NULL);
 
   if (__builtin_expect (invalid_handle(handle, __th), 0)) {
@@ -213,12 +222,14 @@ int pthread_setaffinity_np(pthread_t __th, size_t __cpusetsize,
   pthread_descr th = handle_to_descr(handle);
 
   L4::Cap<L4::Thread> t(th->p_th_cap);
-  l4_sched_param_t sp = l4_sched_param(th->p_priority, 0);
+  int prio = __pthread_l4_getprio(th->p_sched_policy, th->p_priority);
+  l4_sched_param_t sp = l4_sched_param(prio >= 0 ? prio : 2, 0);
   static_assert(sizeof(__cpuset->__bits[0]) == sizeof(l4_umword_t),
                 "Size mismatch");
-  th->p_affinity_mask[0] = __cpuset->__bits[0];
   sp.affinity = l4_sched_cpu_set(0, 0, __cpuset->__bits[0]);
   int e = l4_error(L4Re::Env::env()->scheduler()->run_thread(t, sp));
+  if (e >= 0)
+    th->p_affinity_mask[0] = __cpuset->__bits[0];
 
   __pthread_unlock(handle_to_lock(handle));
 
@@ -238,9 +249,29 @@ pthread_getaffinity_np(pthread_t th, size_t cpusetsize, cpu_set_t *cpuset) __THR
     __pthread_unlock(handle_to_lock(handle));
     return ESRCH;
   }
-  cpuset->__bits[0] = handle_to_descr(handle)->p_affinity_mask[0];
+  unsigned long mask = handle_to_descr(handle)->p_affinity_mask[0];
   __pthread_unlock(handle_to_lock(handle));
 
+  // Report the CPUs the thread can actually run on: the online CPUs of our
+  // scheduler, restricted to the affinity set with pthread_setaffinity_np().
+  memset(cpuset, 0, cpusetsize);
+  cpuset->__bits[0] = mask;
+  // A thread pinned to a single CPU can only run there.
+  if (!(mask & (mask - 1)))
+    return 0;
+
+  size_t words = mask == ~0ul ? cpusetsize / sizeof(cpuset->__bits[0]) : 1;
+  L4::Cap<L4::Scheduler> sched = L4Re::Env::env()->scheduler();
+  for (size_t i = 0; i < words; ++i)
+    {
+      l4_sched_cpu_set_t cs
+        = l4_sched_cpu_set(i * sizeof(cpuset->__bits[0]) * 8, 0, 0);
+      if (l4_error(sched->info(nullptr, &cs)) < 0)
+        break;
+
+      cpuset->__bits[i] = cs.map & (i ? ~0ul : mask);
+    }
+
   return 0;
 }
 
@@ -275,6 +306,7 @@ int pthread_l4_start(pthread_t th, void *(*func)(void *), void *arg)
                                 thread->p_priority);
 
   l4_sched_param_t sp = l4_sched_param(prio >= 0 ? prio : 2);
+  sp.affinity = __pthread_l4_affinity(thread);
   int res = l4_error(L4Re::Env::env()->scheduler()
     ->run_thread(L4::Cap<L4::Thread>(thread->p_th_cap), sp));
 
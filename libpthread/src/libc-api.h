@@ -109,9 +109,9 @@ ptlc_after_create_thread(bool success);
 
 /**
  * Called when a thread exited, after it was removed from the thread list,
- * immedaitely before its thread descriptor freed.
+ * before its thread descriptor is freed.
  *
- * \note Executes on the pthread manager thread.
+ * \note Executes on the exiting thread.
  */
 L4_HIDDEN void
 ptlc_after_exit_thread(void);
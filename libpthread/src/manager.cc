@@ -12,7 +12,8 @@
 /* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the        */
 /* GNU Library General Public License for more details.                 */
 
-/* The "thread manager" thread: manages creation and termination of threads */
+/* The "thread manager" thread: handles process exit and other rare requests.
+   Thread creation and termination are done by the threads themselves. */
 
 #ifndef PT_EI
 #define PT_EI inline
@@ -42,6 +43,7 @@
 #include <l4/sys/factory>
 #include <l4/sys/scheduler>
 #include <l4/sys/thread>
+#include <l4/util/util.h>
 
 extern "C" {
 #include "pthread.h"
@@ -81,6 +83,25 @@ static pthread_descr manager_thread;
 
 static int main_thread_exiting;
 
+/* Lock protecting the doubly linked list of live threads (p_nextlive,
+   p_prevlive) and main_thread_exiting. Threads are created and exit without
+   involving the manager, hence the list is no longer owned by a single
+   thread. Apart from REQ_EXEC_IN_MANAGER callbacks, critical sections never
+   block. */
+
+static struct _pthread_fastlock live_lock = __LOCK_INITIALIZER;
+
+/* Lock protecting the UTCB free list (__pthread_first_free_utcb). */
+
+static struct _pthread_fastlock utcb_lock = __LOCK_INITIALIZER;
+
+/* Exited detached threads waiting for their stack, TLS and capability slots
+   to be released by the next thread entering pthread_create() or
+   pthread_join()/pthread_detach(). Pushed lock-free by the exiting thread,
+   drained as a whole by a single atomic exchange. */
+
+static pthread_descr zombies;
+
 /* Counter used to generate unique thread identifier.
    Thread identifier is pthread_threads_counter + segment. */
 
@@ -88,15 +109,10 @@ static int main_thread_exiting;
 
 /* Forward declarations */
 
-static int pthread_handle_create(pthread_descr creator, const pthread_attr_t *attr,
-                                 void * (*start_routine)(void *), void *arg);
-static void pthread_handle_free(pthread_t th_id);
 static void pthread_handle_exit(pthread_descr issuing_thread, int exitcode);
 //l4/static void pthread_kill_all_threads(int main_thread_also);
 
-static int pthread_handle_thread_exit(pthread_descr th);
-
-/* The server thread managing requests for thread creation and termination */
+/* The server thread managing requests for process exit */
 
 static pthread_descr pthread_first_thread(void)
 {
@@ -118,7 +134,7 @@ int
 __attribute__ ((noreturn))
 __pthread_manager(void *arg)
 {
-  pthread_descr self = manager_thread = (pthread_descr)arg;
+  pthread_descr self = (pthread_descr)arg;
   struct pthread_request request;
 
   __l4_utcb_mark_used(l4_utcb());
@@ -151,29 +167,16 @@ __pthread_manager(void *arg)
       do_reply = 0;
       switch(request.req_kind)
 	{
-	case REQ_CREATE:
-	  request.req_thread->p_retcode =
-	    pthread_handle_create(request.req_thread,
-		request.req_args.create.attr,
-		request.req_args.create.fn,
-		request.req_args.create.arg);
-	  do_reply = 1;
-	  break;
-	case REQ_FREE:
-	  pthread_handle_free(request.req_args.free.thread_id);
-	  break;
 	case REQ_PROCESS_EXIT:
 	  pthread_handle_exit(request.req_thread,
 	      request.req_args.exit.code);
 	  /* NOTREACHED */
 	  break;
 	case REQ_MAIN_THREAD_EXIT:
+	  __pthread_lock(&live_lock, self);
 	  main_thread_exiting = 1;
-          /* Reap children in case all other threads died and the signal handler
-             went off before we set main_thread_exiting to 1, and therefore did
-             not do REQ_KICK. */
-          //l4/pthread_reap_children();
-
+	  /* Threads exit without notifying us, so if all of them are already
+	     gone, nobody else will wake up the main thread. */
 	  if (__pthread_main_thread->p_nextlive == __pthread_main_thread) {
 	      restart(__pthread_main_thread);
 	      /* The main thread will now call exit() which will trigger an
@@ -181,6 +184,7 @@ __pthread_manager(void *arg)
 		 to the thread manager. In case you are wondering how the
 		 manager terminates from its loop here. */
 	  }
+	  __pthread_unlock(&live_lock);
 	  break;
 	case REQ_POST:
 	  sem_post((sem_t*)request.req_args.post);
@@ -193,32 +197,14 @@ __pthread_manager(void *arg)
 	     threads right away, avoiding a potential delay at shutdown. */
 	  break;
 	case REQ_EXEC_IN_MANAGER:
+	  /* Keep the thread list stable while the callback walks it. */
+	  __pthread_lock(&live_lock, self);
 	  request.req_args.exec_in_mgr.fn(&_pthread_mgr_iface,
                                           request.req_args.exec_in_mgr.arg);
+	  __pthread_unlock(&live_lock);
           restart(request.req_thread);
 	  do_reply = 1;
 	  break;
-        case REQ_THREAD_EXIT:
-            {
-              if (!pthread_handle_thread_exit(request.req_thread))
-                {
-                  auto th = request.req_thread;
-                  /* Thread still waiting to be joined. Only release
-                     L4 resources for now. */
-                  // Keep the cap slot allocated and let pthread_free() do the
-                  // final cleanup. This way, we can safely check the
-                  // thread cap index for kernel object presence until
-                  // pthread_join/detach() was called.
-                  l4_fpage_t del_obj[2] =
-                    {
-                      L4::Cap<void>(th->p_thsem_cap).fpage(),
-                      L4::Cap<void>(th->p_th_cap).fpage()
-                    };
-                  L4Re::Env::env()->task()->unmap_batch(del_obj, 2,
-                                                        L4_FP_DELETE_OBJ);
-                }
-            }
-          break;
 	}
       tag = l4_msgtag(0, 0, 0, L4_MSGTAG_SCHEDULE);
     }
@@ -526,10 +512,12 @@ static l4_utcb_t *l4pthr_allocate_more_utcbs_and_claim_utcb()
             err);
 #endif
 
+  __pthread_lock(&utcb_lock, NULL);
   __l4_add_utcbs(kumem, kumem + L4_PAGESIZE);
 
   l4_utcb_t *u = __pthread_first_free_utcb;
   __pthread_first_free_utcb = __l4_utcb_get_next_free(u);
+  __pthread_unlock(&utcb_lock);
   return u;
 }
 
@@ -542,6 +530,7 @@ static inline l4_utcb_t *claim_unused_utcb()
 {
   l4_utcb_t *prev_u = nullptr;
 
+  __pthread_lock(&utcb_lock, NULL);
   for (l4_utcb_t *u = __pthread_first_free_utcb; u; u = __l4_utcb_get_next_free(u))
     {
       if (__l4_utcb_is_usable_now(u))
@@ -550,11 +539,13 @@ static inline l4_utcb_t *claim_unused_utcb()
             __l4_utcb_set_next_free(prev_u, __l4_utcb_get_next_free(u));
           else
             __pthread_first_free_utcb = __l4_utcb_get_next_free(u);
+          __pthread_unlock(&utcb_lock);
           return u;
         }
 
       prev_u = u;
     }
+  __pthread_unlock(&utcb_lock);
 
   return nullptr;
 }
@@ -569,8 +560,10 @@ static inline void mgr_free_utcb(l4_utcb_t *u)
 
   l4_thread_regs_t *tcr = l4_utcb_tcr_u(u);
   tcr->user[0] = 0;
+  __pthread_lock(&utcb_lock, NULL);
   __l4_utcb_set_next_free(u, __pthread_first_free_utcb);
   __pthread_first_free_utcb = u;
+  __pthread_unlock(&utcb_lock);
 }
 
 int __pthread_start_manager(pthread_descr mgr)
@@ -579,6 +572,7 @@ int __pthread_start_manager(pthread_descr mgr)
 
   // This succeeds because of adding UTCBs in __pthread_initialize_minimal().
   mgr->p_tid = thread_id(claim_unused_utcb());
+  manager_thread = mgr;
 
   err = __pthread_mgr_create_thread(mgr, &__pthread_manager_thread_tos,
                                     __pthread_manager, -1, 0, l4_sched_cpu_set(0, ~0, 1));
@@ -672,6 +666,13 @@ static int pthread_handle_create(pthread_descr creator, const pthread_attr_t *at
   new_thread->p_sched_policy = creator->p_sched_policy;
   new_thread->p_priority = creator->p_priority;
 
+  l4_sched_cpu_set_t affinity
+    = attr ? attr->affinity : l4_sched_cpu_set(0, ~0, 1);
+  /* Only a plain bitmap of the first CPUs can be represented in the mask,
+     treat anything else as unrestricted. */
+  new_thread->p_affinity_mask[0]
+    = affinity.gran_offset == 0 ? affinity.map : ~0ul;
+
   if (attr != NULL)
     {
       new_thread->p_detached = attr->__detachstate;
@@ -697,9 +698,9 @@ static int pthread_handle_create(pthread_descr creator, const pthread_attr_t *at
       /* Raise priority of thread manager if needed */
       __pthread_manager_adjust_prio(prio);
     }
-  else if (manager_thread->p_sched_policy > 3)
+  else if (creator->p_sched_policy > 3)
     {
-      /* Default scheduling required, but thread manager runs in realtime
+      /* Default scheduling required, but the creating thread runs in realtime
          scheduling: switch new thread to SCHED_OTHER policy */
       prio = __pthread_l4_getprio(SCHED_OTHER, 0);
     }
@@ -710,16 +711,28 @@ static int pthread_handle_create(pthread_descr creator, const pthread_attr_t *at
      functions fail we return an error value and the caller must not use
      the stored thread ID.  */
   creator->p_retval = reinterpret_cast<void *>(new_thread_id);
+  /* Insert new thread in doubly linked list of active threads. This has to
+     happen before the thread starts, because it unlinks itself on exit. */
+  __pthread_lock(&live_lock, creator);
+  new_thread->p_prevlive = __pthread_main_thread;
+  new_thread->p_nextlive = __pthread_main_thread->p_nextlive;
+  __pthread_main_thread->p_nextlive->p_prevlive = new_thread;
+  __pthread_main_thread->p_nextlive = new_thread;
+  __pthread_unlock(&live_lock);
   /* Do the cloning.  We have to use two different functions depending
      on whether we are debugging or not.  */
   err =  __pthread_mgr_create_thread(new_thread, &stack_addr,
                                      pthread_start_thread, prio,
                                      attr ? attr->create_flags : 0,
-                                     attr ? attr->affinity : l4_sched_cpu_set(0, ~0, 1));
+                                     affinity);
   saved_errno = -err;
 
   /* Check if cloning succeeded */
   if (err < 0) {
+    __pthread_lock(&live_lock, creator);
+    new_thread->p_nextlive->p_prevlive = new_thread->p_prevlive;
+    new_thread->p_prevlive->p_nextlive = new_thread->p_nextlive;
+    __pthread_unlock(&live_lock);
     /* Free the stack if we allocated it */
     if (attr == NULL || !attr->__stackaddr_set)
       {
@@ -730,13 +743,6 @@ static int pthread_handle_create(pthread_descr creator, const pthread_attr_t *at
     mgr_free_utcb(new_utcb);
     return saved_errno;
   }
-  /* Insert new thread in doubly linked list of active threads */
-  new_thread->p_prevlive = __pthread_main_thread;
-  new_thread->p_nextlive = __pthread_main_thread->p_nextlive;
-  __pthread_main_thread->p_nextlive->p_prevlive = new_thread;
-  __pthread_main_thread->p_nextlive = new_thread;
-  /* Set pid field of the new thread, in case we get there before the
-     child starts. */
   return 0;
 }
 
@@ -800,49 +806,91 @@ static void pthread_free(pthread_descr th)
   ptlc_deallocate_tls (ptlc_thread_descr_to_tls_tp(th));
 }
 
+/* Release the resources of all exited detached threads. */
+
+static void pthread_reap_zombies(void)
+{
+  pthread_descr th = __atomic_exchange_n(&zombies, (pthread_descr)nullptr,
+                                         __ATOMIC_ACQUIRE);
+  while (th)
+    {
+      pthread_descr next = th->p_nextzombie;
+      pthread_free(th);
+      th = next;
+    }
+}
+
+/* Thread creation, executed on the thread calling pthread_create(). */
+
+int __pthread_create_thread(pthread_descr creator, const pthread_attr_t *attr,
+                            void * (*start_routine)(void *), void *arg)
+{
+  pthread_reap_zombies();
+  return pthread_handle_create(creator, attr, start_routine, arg);
+}
+
 /*
- * Handle threads that have exited
+ * Remove an exiting thread from the list of live threads.
  *
- * Return true if the thread has been freed due to being detached.
+ * Executed on the exiting thread before it is marked as terminated, so that
+ * pthread_join() and pthread_detach() never see a terminated thread which is
+ * still linked.
  */
 
-static int pthread_handle_thread_exit(pthread_descr th)
+void __pthread_unlink_thread(pthread_descr th)
 {
-  if (th->p_exited)
-    return 0;
-
-  assert(th->p_terminated);
-
-  int detached;
-  /* Remove thread from list of active threads */
+  __pthread_lock(&live_lock, th);
   th->p_nextlive->p_prevlive = th->p_prevlive;
   th->p_prevlive->p_nextlive = th->p_nextlive;
-  /* Mark thread as exited, and if detached, free its resources */
-  __pthread_lock(th->p_lock, NULL);
-  th->p_exited = 1;
-  detached = th->p_detached;
-  __pthread_unlock(th->p_lock);
+  /* If all threads have exited and the main thread is pending on a
+     pthread_exit, wake up the main thread. Same logic as
+     REQ_MAIN_THREAD_EXIT. */
+  if (main_thread_exiting &&
+      __pthread_main_thread->p_nextlive == __pthread_main_thread)
+    restart(__pthread_main_thread);
+  __pthread_unlock(&live_lock);
 
   ptlc_after_exit_thread();
+}
+
+/*
+ * Last step of an exiting thread which is not joined yet.
+ *
+ * Executed on the exiting thread after it was marked as exited. Detached
+ * threads are queued for pthread_reap_zombies(). The thread then deletes its
+ * own kernel objects. Any other thread freeing the descriptor deletes them as
+ * well before touching the stack, so it does not matter who comes first.
+ */
 
+void __pthread_release_thread(pthread_descr th, int detached)
+{
   if (detached)
-    pthread_free(th);
-  /* If all threads have exited and the main thread is pending on a
-     pthread_exit, wake up the main thread and terminate ourselves. */
-  if (main_thread_exiting &&
-      __pthread_main_thread->p_nextlive == __pthread_main_thread) {
-    restart(__pthread_main_thread);
-    /* Same logic as REQ_MAIN_THREAD_EXIT. */
-  }
+    {
+      pthread_descr head = __atomic_load_n(&zombies, __ATOMIC_RELAXED);
+      do
+        th->p_nextzombie = head;
+      while (!__atomic_compare_exchange_n(&zombies, &head, th, true,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+    }
+
+  // Keep the cap slots allocated and let pthread_free() do the final
+  // cleanup. This way, we can safely check the thread cap index for kernel
+  // object presence until pthread_join/detach() was called.
+  l4_fpage_t del_obj[2] =
+    {
+      L4::Cap<void>(th->p_thsem_cap).fpage(),
+      L4::Cap<void>(th->p_th_cap).fpage()
+    };
+  L4Re::Env::env()->task()->unmap_batch(del_obj, 2, L4_FP_DELETE_OBJ);
 
-  return detached;
+  l4_sleep_forever();
 }
 
 
-/* Try to free the resources of a thread when requested by pthread_join
+/* Free the resources of a thread when requested by pthread_join
    or pthread_detach on a terminated thread. */
 
-static void pthread_handle_free(pthread_t th_id)
+void __pthread_free_thread(pthread_t th_id)
 {
   pthread_handle handle = thread_handle(th_id);
   pthread_descr th;
@@ -856,8 +904,9 @@ static void pthread_handle_free(pthread_t th_id)
   }
   th = handle_to_descr(handle);
   __pthread_unlock(handle_to_lock(handle));
-  if (!pthread_handle_thread_exit(th))
-    pthread_free(th);
+  pthread_free(th);
+
+  pthread_reap_zombies();
 }
 
 /* Send a signal to all running threads */
@@ -887,12 +936,14 @@ static void pthread_handle_exit(pthread_descr issuing_thread, int exitcode)
   pthread_descr th;
   __pthread_exit_requested = 1;
   __pthread_exit_code = exitcode;
+  __pthread_lock(&live_lock, NULL);
   for (th = issuing_thread->p_nextlive;
        th != issuing_thread;
        th = th->p_nextlive)
     {
       __l4_kill_thread(th->p_th_cap);
     }
+  __pthread_unlock(&live_lock);
 
   // let caller continue
   if (l4_error(l4_ipc_send(L4_INVALID_CAP | L4_SYSF_REPLY,
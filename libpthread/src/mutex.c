@@ -25,6 +25,7 @@
 #include "restart.h"
 
 #include <l4/sys/compiler.h>
+#include <l4/sys/kip.h>
 
 int
 L4_HIDDEN
@@ -40,6 +41,55 @@ __pthread_mutex_init(pthread_mutex_t * mutex,
 }
 L4_STRONG_ALIAS(__pthread_mutex_init, pthread_mutex_init)
 
+/* The status of the underlying fast lock is used as a futex word: 0 is
+   free, 1 is taken and 2 is taken with possible waiters, see futex.c.
+   Adaptive mutexes spin for a while on SMP before they block, the spin
+   count estimate is kept in the spinlock field like before. */
+
+static int
+mutex_lock_word(pthread_mutex_t *mutex, const struct timespec *abstime)
+{
+  long *lock = &mutex->__m_lock.__status;
+  long c;
+
+  if (mutex->__m_kind == PTHREAD_MUTEX_ADAPTIVE_NP
+      && l4_kip()->platform_info.is_mp) {
+    int max_count = mutex->__m_lock.__spinlock * 2 + 10;
+    int spin_count;
+
+    if (max_count > MAX_ADAPTIVE_SPIN_COUNT)
+      max_count = MAX_ADAPTIVE_SPIN_COUNT;
+
+    for (spin_count = 0; spin_count < max_count; spin_count++) {
+      c = 0;
+      if (__atomic_load_n(lock, __ATOMIC_RELAXED) == 0
+          && __atomic_compare_exchange_n(lock, &c, 1, 0, __ATOMIC_ACQUIRE,
+                                         __ATOMIC_RELAXED)) {
+        mutex->__m_lock.__spinlock += (spin_count - mutex->__m_lock.__spinlock) / 8;
+        return 0;
+      }
+#ifdef BUSY_WAIT_NOP
+      BUSY_WAIT_NOP;
+#endif
+    }
+
+    mutex->__m_lock.__spinlock += (spin_count - mutex->__m_lock.__spinlock) / 8;
+  }
+
+  return __pthread_futex_lock(lock, abstime);
+}
+
+static int
+mutex_trylock_word(pthread_mutex_t *mutex)
+{
+  long c = 0;
+
+  if (__atomic_compare_exchange_n(&mutex->__m_lock.__status, &c, 1, 0,
+                                  __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+    return 0;
+  return EBUSY;
+}
+
 int
 L4_HIDDEN
 __pthread_mutex_destroy(pthread_mutex_t * mutex)
@@ -47,9 +97,6 @@ __pthread_mutex_destroy(pthread_mutex_t * mutex)
   switch (mutex->__m_kind) {
   case PTHREAD_MUTEX_ADAPTIVE_NP:
   case PTHREAD_MUTEX_RECURSIVE_NP:
-    if ((mutex->__m_lock.__status & 1) != 0)
-      return EBUSY;
-    return 0;
   case PTHREAD_MUTEX_ERRORCHECK_NP:
   case PTHREAD_MUTEX_TIMED_NP:
     if (mutex->__m_lock.__status != 0)
@@ -70,29 +117,26 @@ __pthread_mutex_trylock(pthread_mutex_t * mutex)
 
   switch(mutex->__m_kind) {
   case PTHREAD_MUTEX_ADAPTIVE_NP:
-    retcode = __pthread_trylock(&mutex->__m_lock);
-    return retcode;
+  case PTHREAD_MUTEX_TIMED_NP:
+    return mutex_trylock_word(mutex);
   case PTHREAD_MUTEX_RECURSIVE_NP:
     self = thread_self();
     if (mutex->__m_owner == self) {
       mutex->__m_count++;
       return 0;
     }
-    retcode = __pthread_trylock(&mutex->__m_lock);
+    retcode = mutex_trylock_word(mutex);
     if (retcode == 0) {
       mutex->__m_owner = self;
       mutex->__m_count = 0;
     }
     return retcode;
   case PTHREAD_MUTEX_ERRORCHECK_NP:
-    retcode = __pthread_alt_trylock(&mutex->__m_lock);
+    retcode = mutex_trylock_word(mutex);
     if (retcode == 0) {
       mutex->__m_owner = thread_self();
     }
     return retcode;
-  case PTHREAD_MUTEX_TIMED_NP:
-    retcode = __pthread_alt_trylock(&mutex->__m_lock);
-    return retcode;
   default:
     return EINVAL;
   }
@@ -107,7 +151,8 @@ __pthread_mutex_lock(pthread_mutex_t * mutex)
 
   switch(mutex->__m_kind) {
   case PTHREAD_MUTEX_ADAPTIVE_NP:
-    __pthread_lock(&mutex->__m_lock, NULL);
+  case PTHREAD_MUTEX_TIMED_NP:
+    mutex_lock_word(mutex, NULL);
     return 0;
   case PTHREAD_MUTEX_RECURSIVE_NP:
     self = thread_self();
@@ -115,19 +160,16 @@ __pthread_mutex_lock(pthread_mutex_t * mutex)
       mutex->__m_count++;
       return 0;
     }
-    __pthread_lock(&mutex->__m_lock, self);
+    mutex_lock_word(mutex, NULL);
     mutex->__m_owner = self;
     mutex->__m_count = 0;
     return 0;
   case PTHREAD_MUTEX_ERRORCHECK_NP:
     self = thread_self();
     if (mutex->__m_owner == self) return EDEADLK;
-    __pthread_alt_lock(&mutex->__m_lock, self);
+    mutex_lock_word(mutex, NULL);
     mutex->__m_owner = self;
     return 0;
-  case PTHREAD_MUTEX_TIMED_NP:
-    __pthread_alt_lock(&mutex->__m_lock, NULL);
-    return 0;
   default:
     return EINVAL;
   }
@@ -142,7 +184,6 @@ __pthread_mutex_timedlock (pthread_mutex_t *mutex,
 			       const struct timespec *abstime)
 {
   pthread_descr self;
-  int res;
 
   if (__builtin_expect (abstime->tv_nsec, 0) < 0
       || __builtin_expect (abstime->tv_nsec, 0) >= 1000000000)
@@ -150,32 +191,26 @@ __pthread_mutex_timedlock (pthread_mutex_t *mutex,
 
   switch(mutex->__m_kind) {
   case PTHREAD_MUTEX_ADAPTIVE_NP:
-    __pthread_lock(&mutex->__m_lock, NULL);
-    return 0;
+  case PTHREAD_MUTEX_TIMED_NP:
+    return mutex_lock_word(mutex, abstime);
   case PTHREAD_MUTEX_RECURSIVE_NP:
     self = thread_self();
     if (mutex->__m_owner == self) {
       mutex->__m_count++;
       return 0;
     }
-    __pthread_lock(&mutex->__m_lock, self);
+    if (mutex_lock_word(mutex, abstime) != 0)
+      return ETIMEDOUT;
     mutex->__m_owner = self;
     mutex->__m_count = 0;
     return 0;
   case PTHREAD_MUTEX_ERRORCHECK_NP:
     self = thread_self();
     if (mutex->__m_owner == self) return EDEADLK;
-    res = __pthread_alt_timedlock(&mutex->__m_lock, self, abstime);
-    if (res != 0)
-      {
-	mutex->__m_owner = self;
-	return 0;
-      }
-    return ETIMEDOUT;
-  case PTHREAD_MUTEX_TIMED_NP:
-    /* Only this type supports timed out lock. */
-    return (__pthread_alt_timedlock(&mutex->__m_lock, NULL, abstime)
-	    ? 0 : ETIMEDOUT);
+    if (mutex_lock_word(mutex, abstime) != 0)
+      return ETIMEDOUT;
+    mutex->__m_owner = self;
+    return 0;
   default:
     return EINVAL;
   }
@@ -188,7 +223,8 @@ __pthread_mutex_unlock(pthread_mutex_t * mutex)
 {
   switch (mutex->__m_kind) {
   case PTHREAD_MUTEX_ADAPTIVE_NP:
-    __pthread_unlock(&mutex->__m_lock);
+  case PTHREAD_MUTEX_TIMED_NP:
+    __pthread_futex_unlock(&mutex->__m_lock.__status);
     return 0;
   case PTHREAD_MUTEX_RECURSIVE_NP:
     if (mutex->__m_owner != thread_self())
@@ -198,16 +234,13 @@ __pthread_mutex_unlock(pthread_mutex_t * mutex)
       return 0;
     }
     mutex->__m_owner = NULL;
-    __pthread_unlock(&mutex->__m_lock);
+    __pthread_futex_unlock(&mutex->__m_lock.__status);
     return 0;
   case PTHREAD_MUTEX_ERRORCHECK_NP:
     if (mutex->__m_owner != thread_self() || mutex->__m_lock.__status == 0)
       return EPERM;
     mutex->__m_owner = NULL;
-    __pthread_alt_unlock(&mutex->__m_lock);
-    return 0;
-  case PTHREAD_MUTEX_TIMED_NP:
-    __pthread_alt_unlock(&mutex->__m_lock);
+    __pthread_futex_unlock(&mutex->__m_lock.__status);
     return 0;
   default:
     return EINVAL;
@@ -215,6 +248,41 @@ __pthread_mutex_unlock(pthread_mutex_t * mutex)
 }
 L4_STRONG_ALIAS(__pthread_mutex_unlock, pthread_mutex_unlock)
 
+/* Release the mutex for a condition variable wait, whatever its recursion
+   count. Returns the count to restore afterwards. */
+
+int
+L4_HIDDEN
+__pthread_mutex_cond_unlock(pthread_mutex_t * mutex)
+{
+  int count = 0;
+
+  if (mutex->__m_kind == PTHREAD_MUTEX_RECURSIVE_NP
+      || mutex->__m_kind == PTHREAD_MUTEX_ERRORCHECK_NP) {
+    count = mutex->__m_count;
+    mutex->__m_count = 0;
+    mutex->__m_owner = NULL;
+  }
+  __pthread_futex_unlock(&mutex->__m_lock.__status);
+  return count;
+}
+
+/* Take the mutex back after a condition variable wait. The waiter may have
+   been requeued to the mutex by pthread_cond_broadcast, so others may wait
+   for it too. */
+
+void
+L4_HIDDEN
+__pthread_mutex_cond_lock(pthread_mutex_t * mutex, int count)
+{
+  __pthread_futex_lock_contended(&mutex->__m_lock.__status);
+  if (mutex->__m_kind == PTHREAD_MUTEX_RECURSIVE_NP
+      || mutex->__m_kind == PTHREAD_MUTEX_ERRORCHECK_NP) {
+    mutex->__m_owner = thread_self();
+    mutex->__m_count = count;
+  }
+}
+
 int
 L4_HIDDEN
 __pthread_mutexattr_init(pthread_mutexattr_t *attr)
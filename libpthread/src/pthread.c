@@ -282,7 +282,6 @@ __pthread_create(pthread_t *thread, const pthread_attr_t *attr,
 			 void * (*start_routine)(void *), void *arg)
 {
   pthread_descr self = thread_self();
-  struct pthread_request request;
   int retval;
   if (__builtin_expect (l4_is_invalid_cap(__pthread_manager_request), 0)) {
     if ((retval = ptlc_become_threaded()))
@@ -294,13 +293,9 @@ __pthread_create(pthread_t *thread, const pthread_attr_t *attr,
 
   ptlc_before_create_thread();
 
-  request.req_thread = self;
-  request.req_kind = REQ_CREATE;
-  request.req_args.create.attr = attr;
-  request.req_args.create.fn = start_routine;
-  request.req_args.create.arg = arg;
-  __pthread_send_manager_rq(&request, 1);
-  retval = THREAD_GETMEM(self, p_retcode);
+  /* The manager is only needed for process exit, create the thread
+     ourselves. */
+  retval = __pthread_create_thread(self, attr, start_routine, arg);
   if (__builtin_expect (retval, 0) == 0)
     *thread = (pthread_t) THREAD_GETMEM(self, p_retval);
   ptlc_after_create_thread(retval == 0);
@@ -21,40 +21,50 @@
 
 #include <bits/libc-lock.h>
 #include <errno.h>
+#include <limits.h>
 #include <pthread.h>
 #include <stdlib.h>
 #include "internals.h"
-#include "queue.h"
 #include "spinlock.h"
-#include "restart.h"
 
 #include <l4/sys/compiler.h>
 
-/* Function called by pthread_cancel to remove the thread from
-   waiting inside pthread_rwlock_timedrdlock or pthread_rwlock_timedwrlock. */
+/* The internal lock is a futex lock on the status of __rw_lock. Waiting
+   readers and writers block on their own wake-up sequence, which is
+   advanced whenever they may be able to proceed. None of the waits is a
+   cancellation point. */
 
-static int rwlock_rd_extricate_func(void *obj, pthread_descr th)
+static inline void
+rwlock_lock(pthread_rwlock_t *rwlock)
 {
-  pthread_rwlock_t *rwlock = obj;
-  int did_remove = 0;
-
-  __pthread_lock(&rwlock->__rw_lock, NULL);
-  did_remove = remove_from_queue(&rwlock->__rw_read_waiting, th);
-  __pthread_unlock(&rwlock->__rw_lock);
+  __pthread_futex_lock(&rwlock->__rw_lock.__status, NULL);
+}
 
-  return did_remove;
+static inline void
+rwlock_unlock(pthread_rwlock_t *rwlock)
+{
+  __pthread_futex_unlock(&rwlock->__rw_lock.__status);
 }
 
-static int rwlock_wr_extricate_func(void *obj, pthread_descr th)
+/*
+ * Wait for the next wake-up of readers or writers. The internal lock must be
+ * locked upon entry, it is locked again on return.
+ */
+
+static int
+rwlock_wait(pthread_rwlock_t *rwlock, long *seq, int *waiters,
+	    const struct timespec *abstime)
 {
-  pthread_rwlock_t *rwlock = obj;
-  int did_remove = 0;
+  long val = *seq;
+  int res;
 
-  __pthread_lock(&rwlock->__rw_lock, NULL);
-  did_remove = remove_from_queue(&rwlock->__rw_write_waiting, th);
-  __pthread_unlock(&rwlock->__rw_lock);
+  ++*waiters;
+  rwlock_unlock(rwlock);
+  res = __pthread_futex_wait(seq, val, abstime, 0);
+  rwlock_lock(rwlock);
+  --*waiters;
 
-  return did_remove;
+  return res;
 }
 
 /*
@@ -153,7 +163,7 @@ rwlock_can_rdlock(pthread_rwlock_t *rwlock, int have_lock_already)
     return 1;
 
   /* Lock prefers writers, but none are waiting. */
-  if (queue_is_empty(&rwlock->__rw_write_waiting))
+  if (rwlock->__rw_write_waiters == 0)
     return 1;
 
   /* Writers are waiting, but this thread already has a read lock */
@@ -220,8 +230,10 @@ __pthread_rwlock_init (pthread_rwlock_t *rwlock,
   __pthread_init_lock(&rwlock->__rw_lock);
   rwlock->__rw_readers = 0;
   rwlock->__rw_writer = NULL;
-  rwlock->__rw_read_waiting = NULL;
-  rwlock->__rw_write_waiting = NULL;
+  rwlock->__rw_read_seq = 0;
+  rwlock->__rw_write_seq = 0;
+  rwlock->__rw_read_waiters = 0;
+  rwlock->__rw_write_waiters = 0;
 
   if (attr == NULL)
     {
@@ -245,10 +257,10 @@ __pthread_rwlock_destroy (pthread_rwlock_t *rwlock)
   int readers;
   _pthread_descr writer;
 
-  __pthread_lock (&rwlock->__rw_lock, NULL);
+  rwlock_lock (rwlock);
   readers = rwlock->__rw_readers;
   writer = rwlock->__rw_writer;
-  __pthread_unlock (&rwlock->__rw_lock);
+  rwlock_unlock (rwlock);
 
   if (readers > 0 || writer != NULL)
     return EBUSY;
@@ -270,20 +282,13 @@ __pthread_rwlock_rdlock (pthread_rwlock_t *rwlock)
   if (self == NULL)
     self = thread_self ();
 
-  for (;;)
-    {
-      __pthread_lock (&rwlock->__rw_lock, self);
-
-      if (rwlock_can_rdlock(rwlock, have_lock_already))
-	break;
-
-      enqueue (&rwlock->__rw_read_waiting, self);
-      __pthread_unlock (&rwlock->__rw_lock);
-      suspend (self); /* This is not a cancellation point */
-    }
+  rwlock_lock (rwlock);
+  while (!rwlock_can_rdlock(rwlock, have_lock_already))
+    rwlock_wait (rwlock, &rwlock->__rw_read_seq, &rwlock->__rw_read_waiters,
+		 NULL);
 
   ++rwlock->__rw_readers;
-  __pthread_unlock (&rwlock->__rw_lock);
+  rwlock_unlock (rwlock);
 
   if (have_lock_already || out_of_mem)
     {
@@ -304,7 +309,6 @@ __pthread_rwlock_timedrdlock (pthread_rwlock_t *rwlock,
   pthread_descr self = NULL;
   pthread_readlock_info *existing;
   int out_of_mem, have_lock_already;
-  pthread_extricate_if extr;
 
   if (abstime->tv_nsec < 0 || abstime->tv_nsec >= 1000000000)
     return EINVAL;
@@ -315,46 +319,20 @@ __pthread_rwlock_timedrdlock (pthread_rwlock_t *rwlock,
   if (self == NULL)
     self = thread_self ();
 
-  /* Set up extrication interface */
-  extr.pu_object = rwlock;
-  extr.pu_extricate_func = rwlock_rd_extricate_func;
-
-  /* Register extrication interface */
-  __pthread_set_own_extricate_if (self, &extr);
-
-  for (;;)
+  rwlock_lock (rwlock);
+  while (!rwlock_can_rdlock(rwlock, have_lock_already))
     {
-      __pthread_lock (&rwlock->__rw_lock, self);
-
-      if (rwlock_can_rdlock(rwlock, have_lock_already))
-	break;
-
-      enqueue (&rwlock->__rw_read_waiting, self);
-      __pthread_unlock (&rwlock->__rw_lock);
-      /* This is not a cancellation point */
-      if (timedsuspend (self, abstime) == 0)
+      if (rwlock_wait (rwlock, &rwlock->__rw_read_seq,
+		       &rwlock->__rw_read_waiters, abstime) == ETIMEDOUT
+	  && !rwlock_can_rdlock(rwlock, have_lock_already))
 	{
-	  int was_on_queue;
-
-	  __pthread_lock (&rwlock->__rw_lock, self);
-	  was_on_queue = remove_from_queue (&rwlock->__rw_read_waiting, self);
-	  __pthread_unlock (&rwlock->__rw_lock);
-
-	  if (was_on_queue)
-	    {
-	      __pthread_set_own_extricate_if (self, 0);
-	      return ETIMEDOUT;
-	    }
-
-	  /* Eat the outstanding restart() from the signaller */
-	  suspend (self);
+	  rwlock_unlock (rwlock);
+	  return ETIMEDOUT;
 	}
     }
 
-  __pthread_set_own_extricate_if (self, 0);
-
   ++rwlock->__rw_readers;
-  __pthread_unlock (&rwlock->__rw_lock);
+  rwlock_unlock (rwlock);
 
   if (have_lock_already || out_of_mem)
     {
@@ -379,7 +357,7 @@ __pthread_rwlock_tryrdlock (pthread_rwlock_t *rwlock)
   have_lock_already = rwlock_have_already(&self, rwlock,
       &existing, &out_of_mem);
 
-  __pthread_lock (&rwlock->__rw_lock, self);
+  rwlock_lock (rwlock);
 
   /* 0 is passed to here instead of have_lock_already.
      This is to meet Single Unix Spec requirements:
@@ -393,7 +371,7 @@ __pthread_rwlock_tryrdlock (pthread_rwlock_t *rwlock)
       retval = 0;
     }
 
-  __pthread_unlock (&rwlock->__rw_lock);
+  rwlock_unlock (rwlock);
 
   if (retval == 0)
     {
@@ -416,21 +394,14 @@ __pthread_rwlock_wrlock (pthread_rwlock_t *rwlock)
 {
   pthread_descr self = thread_self ();
 
-  while(1)
-    {
-      __pthread_lock (&rwlock->__rw_lock, self);
-      if (rwlock->__rw_readers == 0 && rwlock->__rw_writer == NULL)
-	{
-	  rwlock->__rw_writer = self;
-	  __pthread_unlock (&rwlock->__rw_lock);
-	  return 0;
-	}
+  rwlock_lock (rwlock);
+  while (rwlock->__rw_readers != 0 || rwlock->__rw_writer != NULL)
+    rwlock_wait (rwlock, &rwlock->__rw_write_seq,
+		 &rwlock->__rw_write_waiters, NULL);
 
-      /* Suspend ourselves, then try again */
-      enqueue (&rwlock->__rw_write_waiting, self);
-      __pthread_unlock (&rwlock->__rw_lock);
-      suspend (self); /* This is not a cancellation point */
-    }
+  rwlock->__rw_writer = self;
+  rwlock_unlock (rwlock);
+  return 0;
 }
 L4_STRONG_ALIAS(__pthread_rwlock_wrlock, pthread_rwlock_wrlock)
 
@@ -440,54 +411,42 @@ __pthread_rwlock_timedwrlock (pthread_rwlock_t *rwlock,
 			      const struct timespec *abstime)
 {
   pthread_descr self;
-  pthread_extricate_if extr;
+  int wake_readers = 0;
 
   if (abstime->tv_nsec < 0 || abstime->tv_nsec >= 1000000000)
     return EINVAL;
 
   self = thread_self ();
 
-  /* Set up extrication interface */
-  extr.pu_object = rwlock;
-  extr.pu_extricate_func =  rwlock_wr_extricate_func;
-
-  /* Register extrication interface */
-  __pthread_set_own_extricate_if (self, &extr);
-
-  while(1)
+  rwlock_lock (rwlock);
+  while (rwlock->__rw_readers != 0 || rwlock->__rw_writer != NULL)
     {
-      __pthread_lock (&rwlock->__rw_lock, self);
+      if (rwlock_wait (rwlock, &rwlock->__rw_write_seq,
+		       &rwlock->__rw_write_waiters, abstime) != ETIMEDOUT)
+	continue;
 
+      /* Take the lock if it became free in the meantime, so a wake-up
+	 meant for us is not lost. */
       if (rwlock->__rw_readers == 0 && rwlock->__rw_writer == NULL)
-	{
-	  rwlock->__rw_writer = self;
-	  __pthread_set_own_extricate_if (self, 0);
-	  __pthread_unlock (&rwlock->__rw_lock);
-	  return 0;
-	}
+	break;
 
-      /* Suspend ourselves, then try again */
-      enqueue (&rwlock->__rw_write_waiting, self);
-      __pthread_unlock (&rwlock->__rw_lock);
-      /* This is not a cancellation point */
-      if (timedsuspend (self, abstime) == 0)
+      /* Readers held back for us may go now. */
+      if (rwlock->__rw_write_waiters == 0 && rwlock->__rw_writer == NULL
+	  && rwlock->__rw_read_waiters > 0)
 	{
-	  int was_on_queue;
-
-	  __pthread_lock (&rwlock->__rw_lock, self);
-	  was_on_queue = remove_from_queue (&rwlock->__rw_write_waiting, self);
-	  __pthread_unlock (&rwlock->__rw_lock);
-
-	  if (was_on_queue)
-	    {
-	      __pthread_set_own_extricate_if (self, 0);
-	      return ETIMEDOUT;
-	    }
-
-	  /* Eat the outstanding restart() from the signaller */
-	  suspend (self);
+	  ++rwlock->__rw_read_seq;
+	  wake_readers = 1;
 	}
+      rwlock_unlock (rwlock);
+
+      if (wake_readers)
+	__pthread_futex_wake (&rwlock->__rw_read_seq, INT_MAX);
+      return ETIMEDOUT;
     }
+
+  rwlock->__rw_writer = self;
+  rwlock_unlock (rwlock);
+  return 0;
 }
 L4_STRONG_ALIAS(__pthread_rwlock_timedwrlock, pthread_rwlock_timedwrlock)
 
@@ -497,13 +456,13 @@ __pthread_rwlock_trywrlock (pthread_rwlock_t *rwlock)
 {
   int result = EBUSY;
 
-  __pthread_lock (&rwlock->__rw_lock, NULL);
+  rwlock_lock (rwlock);
   if (rwlock->__rw_readers == 0 && rwlock->__rw_writer == NULL)
     {
       rwlock->__rw_writer = thread_self ();
       result = 0;
     }
-  __pthread_unlock (&rwlock->__rw_lock);
+  rwlock_unlock (rwlock);
 
   return result;
 }
@@ -513,57 +472,64 @@ L4_STRONG_ALIAS(__pthread_rwlock_trywrlock, pthread_rwlock_trywrlock)
 int
 __pthread_rwlock_unlock (pthread_rwlock_t *rwlock)
 {
-  pthread_descr torestart;
-  pthread_descr th;
+  long *towake = NULL;
+  int count = 0;
 
-  __pthread_lock (&rwlock->__rw_lock, NULL);
+  rwlock_lock (rwlock);
   if (rwlock->__rw_writer != NULL)
     {
       /* Unlocking a write lock.  */
       if (rwlock->__rw_writer != thread_self ())
 	{
-	  __pthread_unlock (&rwlock->__rw_lock);
+	  rwlock_unlock (rwlock);
 	  return EPERM;
 	}
       rwlock->__rw_writer = NULL;
 
       if ((rwlock->__rw_kind == PTHREAD_RWLOCK_PREFER_READER_NP
-	   && !queue_is_empty(&rwlock->__rw_read_waiting))
-	  || (th = dequeue(&rwlock->__rw_write_waiting)) == NULL)
+	   && rwlock->__rw_read_waiters > 0)
+	  || rwlock->__rw_write_waiters == 0)
 	{
 	  /* Restart all waiting readers.  */
-	  torestart = rwlock->__rw_read_waiting;
-	  rwlock->__rw_read_waiting = NULL;
-	  __pthread_unlock (&rwlock->__rw_lock);
-	  while ((th = dequeue (&torestart)) != NULL)
-	    restart (th);
+	  if (rwlock->__rw_read_waiters > 0)
+	    {
+	      ++rwlock->__rw_read_seq;
+	      towake = &rwlock->__rw_read_seq;
+	      count = INT_MAX;
+	    }
 	}
       else
 	{
 	  /* Restart one waiting writer.  */
-	  __pthread_unlock (&rwlock->__rw_lock);
-	  restart (th);
+	  ++rwlock->__rw_write_seq;
+	  towake = &rwlock->__rw_write_seq;
+	  count = 1;
 	}
+      rwlock_unlock (rwlock);
+
+      if (towake != NULL)
+	__pthread_futex_wake (towake, count);
     }
   else
     {
       /* Unlocking a read lock.  */
       if (rwlock->__rw_readers == 0)
 	{
-	  __pthread_unlock (&rwlock->__rw_lock);
+	  rwlock_unlock (rwlock);
 	  return EPERM;
 	}
 
       --rwlock->__rw_readers;
-      if (rwlock->__rw_readers == 0)
-	/* Restart one waiting writer, if any.  */
-	th = dequeue (&rwlock->__rw_write_waiting);
-      else
-	th = NULL;
+      if (rwlock->__rw_readers == 0 && rwlock->__rw_write_waiters > 0)
+	{
+	  /* Restart one waiting writer.  */
+	  ++rwlock->__rw_write_seq;
+	  towake = &rwlock->__rw_write_seq;
+	}
 
-      __pthread_unlock (&rwlock->__rw_lock);
-      if (th != NULL)
-	restart (th);
+      rwlock_unlock (rwlock);
+      if (towake != NULL)
+	__pthread_futex_wake (towake, 1);
 
       /* Recursive lock fixup */
 
@@ -0,0 +1,212 @@
+/*
+ * Copyright (C) 2026 Kernkonzept GmbH.
+ *
+ * License: see LICENSE.spdx (in this directory or the directories above)
+ */
+
+#include <algorithm>
+#include <cinttypes>
+#include <l4/sys/kip.h>
+#include <l4/re/env.h>
+#include <l4/utrace/trace_export>
+
+namespace utrace {
+
+/// Process IDs used in the trace document.
+enum : unsigned { Pid_kernel = 0, Pid_task = 1 };
+
+/// Events dequeued from a ring per call.
+static constexpr size_t batch_items = 256;
+
+Trace_export::Trace_export(std::FILE *out, bool kernel)
+  : _out(out), _kernel(kernel)
+{
+  if (_kernel)
+    Tracebuffer::validate();
+
+  std::fputs("{\"traceEvents\":[\n", _out);
+  write_metadata(Pid_task, "task");
+  if (_kernel)
+    write_metadata(Pid_kernel, "kernel");
+}
+
+Trace_export::~Trace_export()
+{ finish(); }
+
+size_t Trace_export::poll()
+{
+  if (_done)
+    return 0;
+
+  _user_items.clear();
+  _kernel_items.clear();
+  _records.clear();
+
+  collect_user();
+  if (_kernel)
+    collect_kernel();
+
+  std::stable_sort(_records.begin(), _records.end(),
+                   [](Record const &a, Record const &b)
+                   { return a.time < b.time; });
+
+  for (auto const &r: _records)
+    {
+      if (r.kernel)
+        write_kernel(_kernel_items[r.idx], r.time);
+      else
+        write_user(_user_items[r.idx]);
+    }
+
+  return _records.size();
+}
+
+void Trace_export::finish()
+{
+  if (_done)
+    return;
+
+  poll();
+  std::fputs("\n]}\n", _out);
+  std::fflush(_out);
+  _done = true;
+}
+
+void Trace_export::collect_user()
+{
+  auto &buffer = User_tracebuffer::instance();
+  User_event items[batch_items];
+
+  for (unsigned i = 0; i < User_tracebuffer::num_rings; ++i)
+    {
+      auto *ring = buffer.ring(i);
+      if (!ring)
+        continue;
+
+      if (!_consumers[i])
+        _consumers[i] = std::make_unique<User_tracebuffer::Consumer>(
+                          ring->status, ring->slots);
+
+      for (;;)
+        {
+          User_tracebuffer::Sequence drops = 0;
+          size_t n = _consumers[i]->dequeue(
+                       items, batch_items, 0,
+                       User_tracebuffer::Consumer::Drop_policy::Minimal,
+                       [](size_t) { return true; }, &drops);
+          _drops += drops;
+
+          for (size_t k = 0; k < n; ++k)
+            {
+              _records.push_back(Record{items[k].time, false,
+                                        _user_items.size()});
+              _user_items.push_back(items[k]);
+            }
+
+          if (!n && !drops)
+            break;
+        }
+    }
+}
+
+void Trace_export::collect_kernel()
+{
+  auto &tbuf = Tracebuffer::instance();
+  Tracebuffer::Item items[batch_items];
+
+  // The kernel only records the lower 32 bits of the KIP clock.
+  l4_uint64_t now = l4_kip_clock(l4re_kip());
+
+  for (;;)
+    {
+      Tracebuffer::Sequence drops = 0;
+      size_t n = tbuf.dequeue(items, batch_items, 0,
+                              Tracebuffer::Drop_policy::Minimal, &drops);
+      _drops += drops;
+
+      for (size_t k = 0; k < n; ++k)
+        {
+          l4_uint64_t t = (now & ~0xffffffffULL) | items[k]._kclock;
+          if (t > now)
+            t -= 1ULL << 32;
+
+          _records.push_back(Record{t, true, _kernel_items.size()});
+          _kernel_items.push_back(items[k]);
+        }
+
+      if (!n && !drops)
+        break;
+    }
+}
+
+void Trace_export::separator()
+{
+  if (!_first)
+    std::fputs(",\n", _out);
+  _first = false;
+}
+
+void Trace_export::write_metadata(unsigned pid, char const *name)
+{
+  separator();
+  std::fprintf(_out,
+               "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%u,"
+               "\"args\":{\"name\":\"%s\"}}", pid, name);
+}
+
+void Trace_export::write_user(User_event const &e)
+{
+  separator();
+  std::fprintf(_out,
+               "{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%c\","
+               "\"ts\":%" PRIu64 ",\"pid\":%u,\"tid\":%lu,",
+               e.tp->name(), e.tp->category(), static_cast<char>(e.phase),
+               static_cast<uint64_t>(e.time), Pid_task,
+               static_cast<unsigned long>(e.thread));
+  if (e.phase == User_event::Instant)
+    std::fputs("\"s\":\"t\",", _out);
+  std::fprintf(_out, "\"args\":{\"a0\":%lu,\"a1\":%lu}}",
+               static_cast<unsigned long>(e.args[0]),
+               static_cast<unsigned long>(e.args[1]));
+}
+
+void Trace_export::write_kernel(Tracebuffer::Item const &e, l4_uint64_t time)
+{
+  separator();
+  std::fprintf(_out,
+               "{\"name\":\"%s\",\"cat\":\"kernel\",\"ph\":\"i\",\"s\":\"t\","
+               "\"ts\":%" PRIu64 ",\"pid\":%u,\"tid\":%lu,"
+               "\"args\":{\"cpu\":%u,\"ip\":%lu}}",
+               kernel_event_name(e._type), static_cast<uint64_t>(time),
+               Pid_kernel, reinterpret_cast<unsigned long>(e._ctx),
+               static_cast<unsigned>(e._cpu),
+               static_cast<unsigned long>(e._ip));
+}
+
+char const *Trace_export::kernel_event_name(unsigned type)
+{
+  switch (type)
+    {
+    case l4_ktrace_tbuf_pf:         return "pf";
+    case l4_ktrace_tbuf_ipc:        return "ipc";
+    case l4_ktrace_tbuf_ipc_res:    return "ipc_res";
+    case l4_ktrace_tbuf_ipc_trace:  return "ipc_trace";
+    case l4_ktrace_tbuf_ke:         return "ke";
+    case l4_ktrace_tbuf_ke_reg:     return "ke_reg";
+    case l4_ktrace_tbuf_breakpoint: return "breakpoint";
+    case l4_ktrace_tbuf_ke_bin:     return "ke_bin";
+    default:                        break;
+    }
+
+  auto it = _kernel_names.find(type);
+  if (it == _kernel_names.end())
+    {
+      auto desc = Tracebuffer::index(type);
+      std::string name = desc ? desc->shortname : "k" + std::to_string(type);
+      it = _kernel_names.emplace(type, name).first;
+    }
+
+  return it->second.c_str();
+}
+
+} // namespace utrace
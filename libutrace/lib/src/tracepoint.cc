@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2026 Kernkonzept GmbH.
+ *
+ * License: see LICENSE.spdx (in this directory or the directories above)
+ */
+
+#include <cstring>
+#include <new>
+#include <l4/sys/kip.h>
+#include <l4/sys/utcb.h>
+#include <l4/re/cap_alloc>
+#include <l4/re/env>
+#include <l4/re/mem_alloc>
+#include <l4/re/rm>
+#include <l4/re/unique_cap>
+#include <l4/utrace/tracepoint>
+
+namespace utrace {
+
+/// Head of the list of registered tracepoints.
+static std::atomic<Tracepoint *> &tracepoints()
+{
+  static std::atomic<Tracepoint *> head(nullptr);
+  return head;
+}
+
+Tracepoint::Tracepoint(char const *name, char const *category)
+  : _name(name), _category(category), _enabled(false)
+{
+  auto &head = tracepoints();
+  _next = head.load(std::memory_order_relaxed);
+  while (!head.compare_exchange_weak(_next, this, std::memory_order_release,
+                                     std::memory_order_relaxed))
+    ;
+}
+
+void Tracepoint::emit(User_event::Phase phase, l4_umword_t a0,
+                      l4_umword_t a1) const
+{
+  auto *ring = User_tracebuffer::instance().ring();
+  if (!ring)
+    return;
+
+  User_event e;
+  e.number = 0;
+  e.time = l4_kip_clock(l4re_kip());
+  e.tp = this;
+  e.thread = reinterpret_cast<l4_umword_t>(l4_utcb());
+  e.args[0] = a0;
+  e.args[1] = a1;
+  e.phase = phase;
+  ring->producer.enqueue(e);
+}
+
+unsigned Tracepoint::enable_all(bool on, char const *category)
+{
+  unsigned count = 0;
+  for (auto *tp = tracepoints().load(std::memory_order_acquire); tp;
+       tp = tp->_next)
+    if (!category || !std::strcmp(category, tp->_category))
+      {
+        tp->enable(on);
+        ++count;
+      }
+
+  return count;
+}
+
+Tracepoint *Tracepoint::find(char const *name)
+{
+  for (auto *tp = tracepoints().load(std::memory_order_acquire); tp;
+       tp = tp->_next)
+    if (!std::strcmp(name, tp->_name))
+      return tp;
+
+  return nullptr;
+}
+
+User_tracebuffer::Ring::Ring(L4::Cap<L4Re::Dataspace> ds)
+  : producer(status, slots, 0, ring_items), ds(ds)
+{}
+
+User_tracebuffer::Ring *User_tracebuffer::alloc_ring()
+{
+  auto *e = L4Re::Env::env();
+  unsigned long size = l4_round_page(sizeof(Ring));
+
+  auto ds = L4Re::make_unique_cap<L4Re::Dataspace>(L4Re::virt_cap_alloc);
+  if (!ds.is_valid())
+    return nullptr;
+
+  if (e->mem_alloc()->alloc(size, ds.get()) < 0)
+    return nullptr;
+
+  L4Re::Rm::Unique_region<void *> mem;
+  if (e->rm()->attach(&mem, size,
+                      L4Re::Rm::F::Search_addr | L4Re::Rm::F::RW,
+                      L4::Ipc::make_cap_rw(ds.get())) < 0)
+    return nullptr;
+
+  auto *r = new (mem.get()) Ring(ds.get());
+  mem.release();
+  ds.release();
+  return r;
+}
+
+void User_tracebuffer::free_ring(Ring *r)
+{
+  L4::Cap<L4Re::Dataspace> ds = r->ds;
+  r->~Ring();
+  L4Re::Env::env()->rm()->detach(reinterpret_cast<l4_addr_t>(r), 0);
+  L4Re::virt_cap_alloc->release(ds);
+}
+
+User_tracebuffer &User_tracebuffer::instance()
+{
+  static User_tracebuffer singleton;
+  return singleton;
+}
+
+User_tracebuffer::Ring *User_tracebuffer::ring()
+{
+  // UTCBs of a task are allocated consecutively, so consecutive UTCB slots
+  // get distinct rings.
+  auto u = reinterpret_cast<l4_addr_t>(l4_utcb());
+  auto &slot = _rings[(u / L4_UTCB_OFFSET) % num_rings];
+
+  auto *r = slot.load(std::memory_order_acquire);
+  if (r)
+    return r;
+
+  auto *n = alloc_ring();
+  if (!n)
+    return nullptr;
+
+  if (slot.compare_exchange_strong(r, n, std::memory_order_acq_rel))
+    return n;
+
+  // Another thread sharing the slot was faster.
+  free_ring(n);
+  return r;
+}
+
+} // namespace utrace
@@ -6,6 +6,7 @@
  * License: see LICENSE.spdx (in this directory or the directories above)
  */
 #include "dataspace.h"
+#include "dataspace_noncont.h"
 #include "dataspace_util.h"
 #include "globals.h"
 #include "page_alloc.h"
@@ -15,6 +16,7 @@
 
 #include <l4/cxx/iostream>
 #include <l4/cxx/minmax>
+#include <l4/cxx/unique_ptr>
 
 #include <l4/sys/capability>
 #include <l4/sys/cxx/consts>
@@ -119,6 +121,65 @@ Moe::Dataspace::op_copy_in(L4Re::Dataspace::Rights obj,
   return L4_EOK;
 }
 
+l4_ret_t
+Moe::Dataspace::op_copy_in_many(L4Re::Dataspace::Rights obj,
+                                L4::Ipc::Snd_fpage const &src_cap,
+                                L4::Ipc::Array_in_buf<
+                                  L4Re::Dataspace::Copy_range, unsigned char,
+                                  L4Re::Dataspace::Max_copy_ranges>
+                                  const &ranges)
+{
+  Moe::Dataspace *src = 0;
+
+  if (src_cap.id_received())
+    src = dynamic_cast<Moe::Dataspace*>(object_pool.find(src_cap.data()));
+
+  if (!map_flags(obj).w())
+    return -L4_EACCESS;
+
+  if (!src)
+    return -L4_EINVAL;
+
+  for (unsigned i = 0; i < ranges.length; ++i)
+    {
+      L4Re::Dataspace::Copy_range const &r = ranges.data[i];
+      if (r.size)
+        Dataspace_util::copy(this, r.dst_offs, src, r.src_offs, r.size);
+    }
+
+  return L4_EOK;
+}
+
+l4_ret_t
+Moe::Dataspace::op_clone(L4Re::Dataspace::Rights rights,
+                         L4::Ipc::Cap<L4Re::Dataspace> &ds)
+{
+  if (!map_flags(rights).w())
+    return -L4_EACCESS;
+
+  // Only page-wise allocated memory can be shared copy-on-write, a clone of
+  // contiguous or pinned memory would have to be copied eagerly.
+  if (!can_cow() || !dynamic_cast<Moe::Dataspace_noncont *>(this))
+    return -L4_EINVAL;
+
+  cxx::unique_ptr<Moe::Dataspace>
+    c(Moe::Dataspace_noncont::create(qalloc(), size(), cfg(), flags()));
+  if (Obj_list::in_list(this))
+    Obj_list::insert_after(c.get(), Obj_list::iter(this));
+
+  // Shares all allocated pages copy-on-write and write-protects the
+  // mappings of this dataspace.
+  Dataspace_util::copy(c.get(), 0, this, 0, size());
+
+  L4::Cap<L4::Kobject> ko;
+  ko = object_pool.cap_alloc()->alloc(c.get(), "moe-ds");
+  ko->dec_refcnt(1);
+  ds = L4::Ipc::make_cap(L4::cap_reinterpret_cast<L4Re::Dataspace>(ko),
+                         L4_CAP_FPAGE_RWSD);
+  c.release();
+  return L4_EOK;
+}
+
 l4_ret_t
 Moe::Dataspace::map_info(l4_addr_t &, l4_addr_t &) const noexcept
 {
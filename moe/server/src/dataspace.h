@@ -161,6 +161,15 @@ public:
                       L4Re::Dataspace::Offset src_offs,
                       L4Re::Dataspace::Size sz);
 
+  l4_ret_t op_copy_in_many(L4Re::Dataspace::Rights rights,
+                           L4::Ipc::Snd_fpage const &src_cap,
+                           L4::Ipc::Array_in_buf<
+                             L4Re::Dataspace::Copy_range, unsigned char,
+                             L4Re::Dataspace::Max_copy_ranges> const &ranges);
+
+  l4_ret_t op_clone(L4Re::Dataspace::Rights rights,
+                    L4::Ipc::Cap<L4Re::Dataspace> &ds);
+
   l4_ret_t op_info(L4Re::Dataspace::Rights rights, L4Re::Dataspace::Stats &s)
   {
     s.size = size();
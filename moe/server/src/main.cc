@@ -19,6 +19,7 @@
 #include <l4/sys/thread>
 #include <l4/sys/cxx/ipc_server_loop>
 #include <l4/re/error_helper>
+#include <l4/re/util/rpc_stats>
 #include <l4/util/printf_helpers.h>
 
 #include <l4/cxx/exceptions>
@@ -286,7 +287,8 @@ new_sigma0_cap()
 class Loop_hooks :
   public L4::Ipc_svr::Ignore_errors,
   public L4::Ipc_svr::Default_timeout,
-  public L4::Ipc_svr::Compound_reply
+  public L4::Ipc_svr::Compound_reply,
+  public L4Re::Util::Rpc_stats_hooks
 {
 public:
   static void setup_wait(l4_utcb_t *utcb, L4::Ipc_svr::Reply_mode)
@@ -438,6 +440,13 @@ static void hdl_ldr_flags(cxx::String const &args)
   Moe::ldr_flags = lvl;
 }
 
+static bool _rpc_stats;
+
+static void hdl_rpc_stats(cxx::String const &)
+{
+  _rpc_stats = true;
+}
+
 #ifndef CONFIG_MMU
 static void hdl_brk(cxx::String const &args)
 {
@@ -452,6 +461,7 @@ static Get_opt const _options[] = {
       {"--init=",      hdl_init },
       {"--l4re-dbg=",  hdl_l4re_dbg },
       {"--ldr-flags=", hdl_ldr_flags },
+      {"--rpc-stats",  hdl_rpc_stats },
 #ifndef CONFIG_MMU
       {"--brk=",       hdl_brk },
 #endif
@@ -504,6 +514,26 @@ static cxx::Static_container<Moe::Dma_space_mgr> dma_space_mgr;
 static Elf_loader elf_loader;
 static L4::Server<Loop_hooks> server;
 
+/**
+ * Record per-opcode statistics of the server loop into a read-only
+ * dataspace registered as 'rpc_stats' in the root name space.
+ */
+static void
+init_rpc_stats()
+{
+  enum { Size = 4 * L4_PAGESIZE };
+
+  void *mem = Single_page_alloc_base::_alloc(Size);
+  memset(mem, 0, Size);
+
+  auto *page = L4Re::Util::Rpc_stats_page::init(mem, Size);
+  auto *ds = new Moe::Dataspace_static(mem, Size, L4Re::Dataspace::F::R);
+  object_pool.cap_alloc()->alloc(ds, "moe-ds-rpc-stats");
+  root_name_space()->register_obj("rpc_stats", 0, ds->obj_cap());
+
+  server.rpc_stats_enable(page, kip());
+}
+
 
 static void init_env()
 {
@@ -639,6 +669,9 @@ int main(int /* argc */, char** /* argv */)
                                         L4_BASE_DEBUGGER_CAP);
       root_name_space()->register_obj("kip", Entry::F_rw, kip_ds->obj_cap());
 
+      if (_rpc_stats)
+        init_rpc_stats();
+
       // dump name space information
       if (boot.is_active())
         {
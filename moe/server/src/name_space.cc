@@ -32,6 +32,9 @@ static Dbg dbg(Dbg::Name_space, "ns");
 
 Entry::~Entry()
 {
+  // Whoever waits for this entry has to look again.
+  wake_waiters();
+
   qalloc()->free(const_cast<char *>(_name.start()));
 
   if (_flags & F_allocated)
@@ -86,16 +89,166 @@ Entry::set_cap_copy(L4::Cap<L4::Kobject> cap)
   _flags |= F_allocated | F_cap;
 }
 
+void
+Notifier_list::free(Q_alloc *qa, Waiter *w)
+{
+  object_pool.cap_alloc()->free(w->notifier);
+  qa->free(w);
+}
+
+l4_ret_t
+Notifier_list::add(Q_alloc *qa, L4::Cap<L4::Triggerable> notifier,
+                   unsigned max)
+{
+  unsigned count = 0;
+  for (Waiter **w = &_first; *w;)
+    {
+      // Drop waiters that gave up and deleted their notifier.
+      if ((*w)->notifier.validate(L4_BASE_TASK_CAP).label() <= 0)
+        {
+          Waiter *dead = *w;
+          *w = dead->next;
+          free(qa, dead);
+          continue;
+        }
+
+      ++count;
+      w = &(*w)->next;
+    }
+
+  if (count >= max)
+    return -L4_EBUSY;
+
+  Waiter *w = qa->make_obj<Waiter>();
+  auto nc = object_pool.cap_alloc()->alloc();
+  if (!nc.is_valid())
+    {
+      qa->free(w);
+      return -L4_ENOMEM;
+    }
+
+  nc.move(notifier);
+  w->notifier = L4::cap_cast<L4::Triggerable>(nc);
+  w->next = _first;
+  _first = w;
+  return L4_EOK;
+}
+
+void
+Notifier_list::trigger_all(Q_alloc *qa)
+{
+  while (Waiter *w = _first)
+    {
+      _first = w->next;
+      w->notifier->trigger();
+      free(qa, w);
+    }
+}
+
 
 Name_space::~Name_space()
 {
+  _watchers.trigger_all(qalloc());
   _tree.remove_all([](Entry *e) { delete e; });
+  if (_index)
+    qalloc()->free(_index);
+}
+
+Entry *
+Name_space::find(char const *name, unsigned long len) const
+{
+  if (!_count)
+    return 0;
+
+  unsigned long mask = _index_size - 1;
+  unsigned long h = Entry::hash(name, len);
+  for (unsigned long i = h & mask; Entry *e = _index[i]; i = (i + 1) & mask)
+    if (e->_hash == h && e->_name.len() == len
+        && !memcmp(e->_name.start(), name, len))
+      return e;
+
+  return 0;
+}
+
+bool
+Name_space::insert(Entry *e)
+{
+  // grow first, so that a failing allocation leaves tree and index intact
+  if ((_count + 1) * 4 > _index_size * 3)
+    index_grow();
+
+  if (!_tree.insert(e).second)
+    return false;
+
+  index_insert(e);
+  _watchers.trigger_all(qalloc());
+  return true;
+}
+
+void
+Name_space::index_insert(Entry *e)
+{
+  unsigned long mask = _index_size - 1;
+  unsigned long i = e->_hash & mask;
+  while (_index[i])
+    i = (i + 1) & mask;
+
+  _index[i] = e;
+  ++_count;
+}
+
+void
+Name_space::index_remove(Entry *e)
+{
+  unsigned long mask = _index_size - 1;
+  unsigned long i = e->_hash & mask;
+  while (_index[i] != e)
+    i = (i + 1) & mask;
+
+  _index[i] = 0;
+  --_count;
+
+  // Close the hole: move back every following entry of the cluster whose
+  // probe sequence passes the free slot.
+  for (unsigned long j = (i + 1) & mask; _index[j]; j = (j + 1) & mask)
+    {
+      unsigned long home = _index[j]->_hash & mask;
+      if (((j - home) & mask) >= ((j - i) & mask))
+        {
+          _index[i] = _index[j];
+          _index[j] = 0;
+          i = j;
+        }
+    }
+}
+
+void
+Name_space::index_grow()
+{
+  unsigned long size = _index_size ? _index_size * 2 : Min_index_size;
+  Entry **n = qalloc()->alloc<Entry *>(size);
+  for (unsigned long i = 0; i < size; ++i)
+    n[i] = 0;
+
+  Entry **old = _index;
+  unsigned long old_size = _index_size;
+
+  _index = n;
+  _index_size = size;
+  _count = 0;
+
+  for (unsigned long i = 0; i < old_size; ++i)
+    if (old[i])
+      index_insert(old[i]);
+
+  if (old)
+    qalloc()->free(old);
 }
 
 Entry *
 Name_space::check_existing(Name_buffer const &name, unsigned flags)
 {
-  Entry *n = find(Entry::Name(name.data, name.length));
+  Entry *n = find(name.data, name.length);
   if (n)
     {
       if (!n->is_valid())
@@ -117,34 +270,32 @@ Name_space::check_existing(Name_buffer const &name, unsigned flags)
 Entry *
 Name_space::find_iter(Entry::Name const &pname) const
 {
-  Entry::Name name = pname;
-  dbg.printf("resolve '%.*s': ", name.len(), name.start());
+  char const *name = pname.start();
+  unsigned long len = pname.len();
+  dbg.printf("resolve '%.*s': ", static_cast<int>(len), name);
   Name_space const *ns = this;
   while (ns)
     {
-      cxx::String::Index sep = name.find("/");
-      cxx::String part;
-      if (!name.eof(sep))
-        part = name.head(sep);
-      else
-        part = name;
+      auto *sep = static_cast<char const *>(memchr(name, '/', len));
+      unsigned long part = sep ? sep - name : len;
 
-      dbg.cprintf(" '%.*s'", part.len(), part.start());
-      Entry *o = ns->find(Entry::Name(part.start(), part.len()));
+      dbg.cprintf(" '%.*s'", static_cast<int>(part), name);
+      Entry *o = ns->find(name, part);
 
       if (!o || !o->is_local())
         {
           dbg.cprintf(": resolution failed: '%.*s' remaining\n",
-                      name.len(), name.start());
+                      static_cast<int>(len), name);
           return 0;
         }
 
       ns = dynamic_cast<Name_space const *>(o->_obj.get());
       if (ns)
         {
-          if (!name.eof(sep))
+          if (sep)
             {
-              name = name.substr(sep + 1);
+              name = sep + 1;
+              len -= part + 1;
               continue;
             }
         }
@@ -159,7 +310,6 @@ Name_space::find_iter(Entry::Name const &pname) const
   return 0;
 }
 
-
 l4_ret_t
 Name_space::op_register_obj(L4Re::Namespace::Rights, unsigned flags,
                             Name_buffer const &name, L4::Ipc::Snd_fpage &cap)
@@ -209,7 +359,7 @@ Name_space::op_unlink(L4Re::Namespace::Rights, Name_buffer const &name)
   else
     part = name.length;
 
-  Entry *n = find(Entry::Name(name.data, part));
+  Entry *n = find(name.data, part);
   if (!n)
     return -L4_ENOENT;
 
@@ -242,7 +392,7 @@ Name_space::op_query(L4Re::Namespace::Rights,
   else
     part = name.length;
 
-  Entry *n = find(Entry::Name(name.data, part));
+  Entry *n = find(name.data, part);
   if (!n)
     return -L4_ENOENT;
   if (!n->is_valid())
@@ -286,6 +436,36 @@ Name_space::op_query(L4Re::Namespace::Rights,
 }
 
 
+l4_ret_t
+Name_space::op_notify(L4Re::Namespace::Rights, Name_buffer const &name,
+                      L4::Ipc::Snd_fpage const &notifier)
+{
+  if (memchr(name.data, '/', name.length))
+    return -L4_EINVAL;
+
+  if (!notifier.cap_received())
+    return -L4_EINVAL;
+
+  L4::Cap<L4::Triggerable> rcv(Rcv_cap << L4_CAP_SHIFT);
+
+  // An empty name watches the whole name space.
+  if (name.length == 0)
+    return _watchers.add(qalloc(), rcv, Max_watchers);
+
+  Entry *n = find(name.data, name.length);
+  if (!n)
+    return -L4_ENOENT;
+
+  // Filled in the meantime, let the client look again right away.
+  if (n->is_valid())
+    {
+      rcv->trigger();
+      return L4_EOK;
+    }
+
+  return n->add_waiter(rcv);
+}
+
 void
 Name_space::dump(bool rec, int indent) const
 {
@@ -27,6 +27,39 @@ namespace Moe {
 
 class Name_space;
 
+/**
+ * Clients waiting for a change, see L4Re::Namespace::notify.
+ *
+ * Every notifier is triggered once and then dropped.
+ */
+class Notifier_list
+{
+public:
+  /**
+   * Add a notifier, taking over the capability.
+   *
+   * Notifiers whose client has deleted the object are dropped first.
+   *
+   * \retval -L4_EBUSY   Already `max` notifiers registered.
+   * \retval -L4_ENOMEM  Out of memory or capability slots.
+   */
+  l4_ret_t add(Q_alloc *qa, L4::Cap<L4::Triggerable> notifier, unsigned max);
+
+  /// Trigger and drop all notifiers.
+  void trigger_all(Q_alloc *qa);
+
+private:
+  struct Waiter
+  {
+    Waiter *next;
+    L4::Cap<L4::Triggerable> notifier;
+  };
+
+  static void free(Q_alloc *qa, Waiter *w);
+
+  Waiter *_first = nullptr;
+};
+
 class Entry
 : public cxx::Avl_tree_node,
   public Q_object
@@ -51,15 +84,20 @@ public:
     F_base_mask  = 0xf00,
   };
 
+  enum { Max_waiters = 8 };
+
 private:
   typedef cxx::Weak_ref<Moe::Server_object> Weak_ref;
+
   Name _name;
+  unsigned long _hash;
   unsigned _flags;
   union
   {
     l4_cap_idx_t _cap;
     Weak_ref _obj;
   };
+  Notifier_list _waiters;
 
   void set(L4::Cap<void> cap);
   void set(Moe::Server_object *o);
@@ -70,7 +108,7 @@ public:
   {}
 
   Entry(char const *name, unsigned long len, unsigned flags)
-  : _flags(flags)
+  : _hash(hash(name, len)), _flags(flags)
   {
     auto namecpy = qalloc()->alloc<char>(len + 1);
     memcpy(namecpy, name, len);
@@ -83,6 +121,15 @@ public:
   Name const &name() const
   { return _name; }
 
+  /// FNV-1a hash of a name, used for the hash index of Name_space.
+  static unsigned long hash(char const *name, unsigned long len)
+  {
+    unsigned long h = 2166136261UL;
+    for (unsigned long i = 0; i < len; ++i)
+      h = (h ^ static_cast<unsigned char>(name[i])) * 16777619UL;
+    return h;
+  }
+
   bool is_dynamic() const
   { return !(_flags & F_static); }
 
@@ -115,6 +162,12 @@ public:
 
   void set_epiface(l4_umword_t data);
   void set_cap_copy(L4::Cap<L4::Kobject> cap);
+
+  l4_ret_t add_waiter(L4::Cap<L4::Triggerable> notifier)
+  { return _waiters.add(qalloc(), notifier, Max_waiters); }
+
+  void wake_waiters()
+  { _waiters.trigger_all(qalloc()); }
 };
 
 struct Entry_get_key
@@ -144,14 +197,45 @@ class Name_space :
   typedef L4::Ipc::Array_in_buf<char, unsigned long> Name_buffer;
   Tree _tree;
 
+  /**
+   * Open-addressing hash index over the entries of _tree.
+   *
+   * Lookups go through the index, the tree keeps the entries sorted for
+   * iteration. Linear probing with backward-shift deletion, sized to a
+   * power of two.
+   */
+  Entry **_index = nullptr;
+  unsigned long _index_size = 0;
+  unsigned long _count = 0;
+
+  enum { Min_index_size = 16 };
+
+  /// Clients waiting for any entry to change, see L4Re::Namespace::notify.
+  Notifier_list _watchers;
+
+  enum { Max_watchers = 64 };
+
+  Entry *find(char const *name, unsigned long len) const;
+
   Entry *find(Entry::Name const &name) const
-  { return _tree.find_node(name); }
+  { return find(name.start(), name.len()); }
 
   Entry *remove(Entry::Name const &name)
-  { return _tree.remove(name); }
+  {
+    Entry *e = _tree.remove(name);
+    if (e)
+      {
+        index_remove(e);
+        _watchers.trigger_all(qalloc());
+      }
+    return e;
+  }
+
+  bool insert(Entry *e);
 
-  bool insert(Entry *e)
-  { return _tree.insert(e).second; }
+  void index_insert(Entry *e);
+  void index_remove(Entry *e);
+  void index_grow();
 
   Entry *check_existing(Name_buffer const &name, unsigned flags);
 
@@ -179,6 +263,9 @@ public:
 
   l4_ret_t op_unlink(L4Re::Namespace::Rights r, Name_buffer const &name);
 
+  l4_ret_t op_notify(L4Re::Namespace::Rights, Name_buffer const &name,
+                     L4::Ipc::Snd_fpage const &notifier);
+
   // internally used to register bootfs files, name spaces...
   template <typename T>
   l4_ret_t register_obj(Entry::Name const &name, unsigned long flags, T cap)
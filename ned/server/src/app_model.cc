@@ -67,6 +67,22 @@ App_model::prog_attach_ds(l4_addr_t addr, unsigned long size,
                                    name, file_offset), what);
 }
 
+void
+App_model::prog_attach_segments(Prog_segment const *segs, unsigned num,
+                                char const *name, char const *what)
+{
+  Ldr::attach_prog_segments(_task->rm(), segs, num, name, L4Re::Rm::Flags(0),
+                            _task->task_cap(),
+                            [](Const_dataspace const &ds) { return ds.get(); },
+                            [&](Prog_segment const &s)
+                            {
+                              prog_attach_ds(s.addr, s.size, s.ds, s.offset,
+                                             s.flags, name, s.file_offset,
+                                             what);
+                            },
+                            what);
+}
+
 int
 App_model::prog_reserve_area(l4_addr_t *start, unsigned long size,
                              L4Re::Rm::Flags flags, unsigned char align)
@@ -84,6 +100,15 @@ App_model::copy_ds(Dataspace dst, unsigned long dst_offs,
                "Ned program launch: copy failed");
 }
 
+void
+App_model::copy_ds_many(Dataspace dst, Const_dataspace src,
+                        L4Re::Dataspace::Copy_range const *ranges,
+                        unsigned num)
+{
+  Ldr::copy_ds_ranges(dst.get(), src.get(), ranges, num,
+                      "Ned program launch: copy failed");
+}
+
 void
 App_model::ds_map_info(Const_dataspace ds, l4_addr_t *start)
 {
@@ -65,10 +65,19 @@ struct App_model : public Ldr::Base_app_model<Stack>
                       char const *name, unsigned long file_offset,
                       char const *what);
 
+  typedef Ldr::Prog_segment<Const_dataspace> Prog_segment;
+
+  void prog_attach_segments(Prog_segment const *segs, unsigned num,
+                            char const *name, char const *what);
+
   static void copy_ds(Dataspace dst, unsigned long dst_offs,
                       Const_dataspace src, unsigned long src_offs,
                       unsigned long size);
 
+  static void copy_ds_many(Dataspace dst, Const_dataspace src,
+                           L4Re::Dataspace::Copy_range const *ranges,
+                           unsigned num);
+
   static void ds_map_info(Const_dataspace ds, l4_addr_t *start);
 
   static bool all_segs_cow() { return false; }
@@ -9,6 +9,7 @@
 #include <l4/sys/err.h>
 #include <l4/re/error_helper>
 #include <l4/ned/cmd_control>
+#include <l4/re/dataspace>
 
 #include <lua.h>
 #include <lauxlib.h>
@@ -70,6 +71,7 @@ static char const *const options = "+e:";
 static struct option const loptions[] =
   {
     { "execute", 1, NULL, 'e' },
+    { "rpc-stats", 0, NULL, 's' },
     { 0, 0, 0, 0 }
   };
 
@@ -225,6 +227,14 @@ int lua(int argc, char const *const *argv)
               fprintf(stderr, "Error executing cmdline statement\n");
             break;
           }
+        case 's':
+          // make the statistics available as L4.Env.rpc_stats
+          Lua::lua_require_module(L, "L4");
+          lua_getfield(L, -1, "Env");
+          Lua::register_cap(L, "rpc_stats", Ned::enable_rpc_stats(),
+                            L4Re::Dataspace::Protocol);
+          lua_pop(L, 2);
+          break;
         default: break;
         }
     }
@@ -7,6 +7,9 @@
 
 #include <l4/cxx/list>
 #include <l4/re/error_helper>
+#include <l4/re/util/cap_alloc>
+
+#include <cstring>
 
 #include "server.h"
 
@@ -28,4 +31,31 @@ void server_loop(bool wait_for_apps)
   server.loop();
 }
 
+/**
+ * Record per-opcode statistics of the server loop into a new dataspace.
+ *
+ * \return The dataspace holding the L4Re::Util::Rpc_stats_page.
+ */
+L4::Cap<L4Re::Dataspace> enable_rpc_stats()
+{
+  enum { Size = 4 * L4_PAGESIZE };
+
+  auto *e = L4Re::Env::env();
+  auto ds = L4Re::chkcap(L4Re::Util::cap_alloc.alloc<L4Re::Dataspace>(),
+                         "Allocate RPC statistics capability.");
+  L4Re::chksys(e->mem_alloc()->alloc(Size, ds),
+               "Allocate RPC statistics dataspace.");
+
+  void *addr = 0;
+  L4Re::chksys(e->rm()->attach(&addr, Size,
+                               L4Re::Rm::F::Search_addr | L4Re::Rm::F::RW,
+                               L4::Ipc::make_cap_rw(ds)),
+               "Attach RPC statistics dataspace.");
+  memset(addr, 0, Size);
+
+  server.rpc_stats_enable(L4Re::Util::Rpc_stats_page::init(addr, Size),
+                          l4re_kip());
+  return ds;
+}
+
 }
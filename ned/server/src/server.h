@@ -10,6 +10,7 @@
 #include <l4/cxx/slist>
 #include <l4/re/util/br_manager>
 #include <l4/re/util/object_registry>
+#include <l4/re/util/rpc_stats>
 
 #include "app_task.h"
 
@@ -20,7 +21,8 @@ struct App_termination {};
 struct Termination_loop_hooks :
   public L4::Ipc_svr::Timeout_queue_hooks<L4Re::Util::Br_manager_timeout_hooks,
                                           L4Re::Util::Br_manager>,
-  public L4::Ipc_svr::Ignore_errors
+  public L4::Ipc_svr::Ignore_errors,
+  public L4Re::Util::Rpc_stats_hooks
 {
   void setup_wait(l4_utcb_t *utcb, L4::Ipc_svr::Reply_mode r)
   {
@@ -37,4 +39,6 @@ extern L4Re::Util::Registry_server<Termination_loop_hooks> server;
 
 void server_loop(bool wait_for_apps);
 
+L4::Cap<L4Re::Dataspace> enable_rpc_stats();
+
 }